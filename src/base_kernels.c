@@ -0,0 +1,495 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   base_kernels.c - fold, reverse, and complement bases; scan qscores      */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from the walk, the merge, the trimming, and the   */
+/*   counting.                                                               */
+/*   Each function works on 32 bytes at once with AVX2, or on 16 bytes with  */
+/*   SSE4.2, when the processor running the program supports it, and one     */
+/*   byte at a time on the rest and on the others.  The instruction set is   */
+/*   asked for at each call, which costs only a look at a variable set up    */
+/*   when the program starts.  Compiled with -DSCALAR_KERNELS, or for other  */
+/*   than x86, the functions work one byte at a time.  Every path gives the  */
+/*   same result.                                                            */
+/*   Quality scores are compared as their codes, e.g. '5' for 20.            */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code; moved uc_only_tcag() and the others      */
+/*                 from read_reads.c                                         */
+/*   Oct 17, 2026  Add count_at_least() for the counting (option -u)         */
+/*                                                                           */
+
+
+#include <limits.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && \
+    !defined(SCALAR_KERNELS)
+#define SIMD_KERNELS
+#include <immintrin.h>
+#endif
+
+
+/**** one byte at a time ****/
+
+char complement_base(char base)
+{
+  switch (base)
+  {
+    case 'T': return 'A';
+    case 'C': return 'G';
+    case 'A': return 'T';
+    case 'G': return 'C';
+    default:  return base;
+  }
+}
+
+
+void fold_scalar(char *seq, int from, int to)
+{
+  int i;
+
+  for (i = from; i < to; i++)
+  {
+    if (seq[i] == 't' || seq[i] == 'c' || seq[i] == 'a' || seq[i] == 'g')
+    { seq[i] -= 'a' - 'A'; }
+  }
+}
+
+
+void reverse_scalar(char *seq, int i, int j, int complement)
+{	/* from i to j (inclusive) */
+  char base;
+
+  for (; i <= j; i++, j--)
+  {
+    base = seq[i];
+    seq[i] = complement ? complement_base(seq[j]) : seq[j];
+    seq[j] = complement ? complement_base(base) : base;
+  }
+}
+
+
+int low_head_scalar(char *qscores, int from, int length, int low)
+{	/* position of the first code from 'from' that is not below low */
+  for (; from < length && qscores[from] < low; from++) ;
+  return from;
+}
+
+
+int low_tail_scalar(char *qscores, int to, int low)
+{	/* position after the last code before 'to' that is not below low */
+  for (; to > 0 && qscores[to - 1] < low; to--) ;
+  return to;
+}
+
+
+int outside_scalar(char *qscores, int from, int length, int low, int high)
+{	/* position of the first code from 'from' out of low to high */
+  for (; from < length; from++)
+  { if (qscores[from] < low || qscores[from] > high) break; }
+  return from;
+}
+
+
+int at_least_scalar(char *qscores, int from, int length, int low)
+{	/* number of codes from 'from' that are not below low */
+  int count = 0;
+
+  for (; from < length; from++) { if (qscores[from] >= low) count++; }
+  return count;
+}
+
+
+#ifdef SIMD_KERNELS
+
+/**** 16 bytes at a time (SSE4.2) ****/
+
+__attribute__((target("sse4.2")))
+static __m128i complement_128(__m128i v)
+{	/* A ^ T == 0x15 and C ^ G == 0x04 */
+  __m128i at = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('A')),
+                            _mm_cmpeq_epi8(v, _mm_set1_epi8('T')));
+  __m128i cg = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('C')),
+                            _mm_cmpeq_epi8(v, _mm_set1_epi8('G')));
+
+  return _mm_xor_si128(v, _mm_or_si128(
+                            _mm_and_si128(at, _mm_set1_epi8(0x15)),
+                            _mm_and_si128(cg, _mm_set1_epi8(0x04))));
+}
+
+
+__attribute__((target("sse4.2")))
+static int fold_128(char *seq, int length)
+{
+  __m128i v, m;
+  int i;
+
+  for (i = 0; i + 16 <= length; i += 16)
+  {
+    v = _mm_loadu_si128((__m128i *)(seq + i));
+    m = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('t')),
+                       _mm_cmpeq_epi8(v, _mm_set1_epi8('c'))),
+          _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('a')),
+                       _mm_cmpeq_epi8(v, _mm_set1_epi8('g'))));
+    v = _mm_xor_si128(v, _mm_and_si128(m, _mm_set1_epi8('a' - 'A')));
+    _mm_storeu_si128((__m128i *)(seq + i), v);
+  }
+  return i;
+}
+
+
+__attribute__((target("sse4.2")))
+static int reverse_128(char *seq, int length, int complement)
+{	/* returns the number of bases done at each end */
+  const __m128i order = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+                                     8, 9, 10, 11, 12, 13, 14, 15);
+  __m128i left, right;
+  int i, j;
+
+  for (i = 0, j = length - 16; j - i >= 16; i += 16, j -= 16)
+  {
+    left = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)(seq + i)), order);
+    right = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)(seq + j)), order);
+    if (complement)
+    { left = complement_128(left); right = complement_128(right); }
+    _mm_storeu_si128((__m128i *)(seq + i), right);
+    _mm_storeu_si128((__m128i *)(seq + j), left);
+  }
+  return i;
+}
+
+
+__attribute__((target("sse4.2")))
+static int low_head_128(char *qscores, int from, int length, char low)
+{
+  __m128i lows = _mm_set1_epi8(low);
+  unsigned int mask;
+
+  for (; from + 16 <= length; from += 16)
+  {
+    mask = (unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(lows,
+             _mm_loadu_si128((__m128i *)(qscores + from))));
+    if (mask != 0xffff) return from + __builtin_ctz(~mask);
+  }
+  return low_head_scalar(qscores, from, length, low);
+}
+
+
+__attribute__((target("sse4.2")))
+static int low_tail_128(char *qscores, int to, char low)
+{
+  __m128i lows = _mm_set1_epi8(low);
+  unsigned int mask;
+
+  for (; to >= 16; to -= 16)
+  {
+    mask = (unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(lows,
+             _mm_loadu_si128((__m128i *)(qscores + to - 16))));
+    if (mask != 0xffff)
+    { return to - 16 + 32 - __builtin_clz(~mask & 0xffff); }
+  }
+  return low_tail_scalar(qscores, to, low);
+}
+
+
+__attribute__((target("sse4.2")))
+static int outside_128(char *qscores, int from, int length,
+                       char low, char high)
+{
+  __m128i lows = _mm_set1_epi8(low), highs = _mm_set1_epi8(high), v;
+  unsigned int mask;
+
+  for (; from + 16 <= length; from += 16)
+  {
+    v = _mm_loadu_si128((__m128i *)(qscores + from));
+    mask = (unsigned int)_mm_movemask_epi8(
+             _mm_or_si128(_mm_cmpgt_epi8(lows, v), _mm_cmpgt_epi8(v, highs)));
+    if (mask != 0) return from + __builtin_ctz(mask);
+  }
+  return outside_scalar(qscores, from, length, low, high);
+}
+
+
+__attribute__((target("sse4.2")))
+static int at_least_128(char *qscores, int length, char low)
+{
+  __m128i lows = _mm_set1_epi8(low);
+  unsigned int mask;
+  int from, count = 0;
+
+  for (from = 0; from + 16 <= length; from += 16)
+  {	/* bits of the codes below low */
+    mask = (unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(lows,
+             _mm_loadu_si128((__m128i *)(qscores + from))));
+    count += 16 - __builtin_popcount(mask);
+  }
+  return count + at_least_scalar(qscores, from, length, low);
+}
+
+
+/**** 32 bytes at a time (AVX2) ****/
+
+__attribute__((target("avx2")))
+static __m256i complement_256(__m256i v)
+{
+  __m256i at = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('A')),
+                               _mm256_cmpeq_epi8(v, _mm256_set1_epi8('T')));
+  __m256i cg = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('C')),
+                               _mm256_cmpeq_epi8(v, _mm256_set1_epi8('G')));
+
+  return _mm256_xor_si256(v, _mm256_or_si256(
+                               _mm256_and_si256(at, _mm256_set1_epi8(0x15)),
+                               _mm256_and_si256(cg, _mm256_set1_epi8(0x04))));
+}
+
+
+__attribute__((target("avx2")))
+static __m256i flip_256(__m256i v)
+{	/* bytes are reversed in each half, and then the halves are swapped */
+  const __m256i order = _mm256_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+                                        8, 9, 10, 11, 12, 13, 14, 15,
+                                        0, 1, 2, 3, 4, 5, 6, 7,
+                                        8, 9, 10, 11, 12, 13, 14, 15);
+
+  return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, order), 0x4e);
+}
+
+
+__attribute__((target("avx2")))
+static int fold_256(char *seq, int length)
+{
+  __m256i v, m;
+  int i;
+
+  for (i = 0; i + 32 <= length; i += 32)
+  {
+    v = _mm256_loadu_si256((__m256i *)(seq + i));
+    m = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('t')),
+                          _mm256_cmpeq_epi8(v, _mm256_set1_epi8('c'))),
+          _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('a')),
+                          _mm256_cmpeq_epi8(v, _mm256_set1_epi8('g'))));
+    v = _mm256_xor_si256(v, _mm256_and_si256(m,
+                                             _mm256_set1_epi8('a' - 'A')));
+    _mm256_storeu_si256((__m256i *)(seq + i), v);
+  }
+  return i;
+}
+
+
+__attribute__((target("avx2")))
+static int reverse_256(char *seq, int length, int complement)
+{
+  __m256i left, right;
+  int i, j;
+
+  for (i = 0, j = length - 32; j - i >= 32; i += 32, j -= 32)
+  {
+    left = flip_256(_mm256_loadu_si256((__m256i *)(seq + i)));
+    right = flip_256(_mm256_loadu_si256((__m256i *)(seq + j)));
+    if (complement)
+    { left = complement_256(left); right = complement_256(right); }
+    _mm256_storeu_si256((__m256i *)(seq + i), right);
+    _mm256_storeu_si256((__m256i *)(seq + j), left);
+  }
+  return i;
+}
+
+
+__attribute__((target("avx2")))
+static int low_head_256(char *qscores, int from, int length, char low)
+{
+  __m256i lows = _mm256_set1_epi8(low);
+  unsigned int mask;
+
+  for (; from + 32 <= length; from += 32)
+  {
+    mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpgt_epi8(lows,
+             _mm256_loadu_si256((__m256i *)(qscores + from))));
+    if (mask != 0xffffffff) return from + __builtin_ctz(~mask);
+  }
+  return low_head_scalar(qscores, from, length, low);
+}
+
+
+__attribute__((target("avx2")))
+static int low_tail_256(char *qscores, int to, char low)
+{
+  __m256i lows = _mm256_set1_epi8(low);
+  unsigned int mask;
+
+  for (; to >= 32; to -= 32)
+  {
+    mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpgt_epi8(lows,
+             _mm256_loadu_si256((__m256i *)(qscores + to - 32))));
+    if (mask != 0xffffffff) return to - __builtin_clz(~mask);
+  }
+  return low_tail_scalar(qscores, to, low);
+}
+
+
+__attribute__((target("avx2")))
+static int outside_256(char *qscores, int from, int length,
+                       char low, char high)
+{
+  __m256i lows = _mm256_set1_epi8(low), highs = _mm256_set1_epi8(high), v;
+  unsigned int mask;
+
+  for (; from + 32 <= length; from += 32)
+  {
+    v = _mm256_loadu_si256((__m256i *)(qscores + from));
+    mask = (unsigned int)_mm256_movemask_epi8(
+             _mm256_or_si256(_mm256_cmpgt_epi8(lows, v),
+                             _mm256_cmpgt_epi8(v, highs)));
+    if (mask != 0) return from + __builtin_ctz(mask);
+  }
+  return outside_scalar(qscores, from, length, low, high);
+}
+
+
+__attribute__((target("avx2")))
+static int at_least_256(char *qscores, int length, char low)
+{
+  __m256i lows = _mm256_set1_epi8(low);
+  unsigned int mask;
+  int from, count = 0;
+
+  for (from = 0; from + 32 <= length; from += 32)
+  {
+    mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpgt_epi8(lows,
+             _mm256_loadu_si256((__m256i *)(qscores + from))));
+    count += 32 - __builtin_popcount(mask);
+  }
+  return count + at_least_scalar(qscores, from, length, low);
+}
+
+
+#define HAS_AVX2 __builtin_cpu_supports("avx2")
+#define HAS_SSE42 __builtin_cpu_supports("sse4.2")
+#endif	/* SIMD_KERNELS */
+
+
+/*                                                                           */
+/* uc_only_tcag()                                                            */
+/*                                                                           */
+/*   This function changes t, c, a, and g to T, C, A, and G, respectively,   */
+/*   in a DNA sequence.                                                      */
+/*                                                                           */
+void uc_only_tcag(char *seq)
+{
+  int length = strlen(seq), i = 0;
+
+#ifdef SIMD_KERNELS
+  if (HAS_AVX2) i = fold_256(seq, length);
+  else if (HAS_SSE42) i = fold_128(seq, length);
+#endif
+  fold_scalar(seq, i, length);
+}
+
+
+int reverse_sequence(char *seq)
+{
+  int length = strlen(seq), i = 0;
+
+#ifdef SIMD_KERNELS
+  if (HAS_AVX2) i = reverse_256(seq, length, 0);
+  else if (HAS_SSE42) i = reverse_128(seq, length, 0);
+#endif
+  reverse_scalar(seq, i, length - 1 - i, 0);
+  return length;
+}
+
+
+int complementary_sequence(char *seq)
+{
+  int length = strlen(seq), i = 0;
+
+#ifdef SIMD_KERNELS
+  if (HAS_AVX2) i = reverse_256(seq, length, 1);
+  else if (HAS_SSE42) i = reverse_128(seq, length, 1);
+#endif
+  reverse_scalar(seq, i, length - 1 - i, 1);
+  return length;
+}
+
+
+/*                                                                           */
+/* count_low_head()                                                          */
+/*                                                                           */
+/*   This function returns the number of quality scores in a row from the    */
+/*   first one whose codes are below low.                                    */
+/*                                                                           */
+int count_low_head(char *qscores, int length, int low)
+{
+#ifdef SIMD_KERNELS
+  if (low > CHAR_MAX) return length > 0 ? length : 0;
+  if (low <= CHAR_MIN) return 0;
+  if (HAS_AVX2) return low_head_256(qscores, 0, length, (char)low);
+  if (HAS_SSE42) return low_head_128(qscores, 0, length, (char)low);
+#endif
+  return low_head_scalar(qscores, 0, length, low);
+}
+
+
+/*                                                                           */
+/* count_at_least()                                                          */
+/*                                                                           */
+/*   This function returns the number of quality scores whose codes are not  */
+/*   below low.                                                              */
+/*                                                                           */
+int count_at_least(char *qscores, int length, int low)
+{
+#ifdef SIMD_KERNELS
+  if (low > CHAR_MAX) return 0;
+  if (low <= CHAR_MIN) return length > 0 ? length : 0;
+  if (HAS_AVX2) return at_least_256(qscores, length, (char)low);
+  if (HAS_SSE42) return at_least_128(qscores, length, (char)low);
+#endif
+  return at_least_scalar(qscores, 0, length, low);
+}
+
+
+/*                                                                           */
+/* count_low_tail()                                                          */
+/*                                                                           */
+/*   This function returns the number of quality scores in a row to the      */
+/*   last one whose codes are below low.                                     */
+/*                                                                           */
+int count_low_tail(char *qscores, int length, int low)
+{
+  if (length <= 0) return 0;
+#ifdef SIMD_KERNELS
+  if (low > CHAR_MAX) return length;
+  if (low <= CHAR_MIN) return 0;
+  if (HAS_AVX2) return length - low_tail_256(qscores, length, (char)low);
+  if (HAS_SSE42) return length - low_tail_128(qscores, length, (char)low);
+#endif
+  return length - low_tail_scalar(qscores, length, low);
+}
+
+
+/*                                                                           */
+/* find_outside()                                                            */
+/*                                                                           */
+/*   This function returns the position of the first quality score from      */
+/*   'from' whose code is below low or above high, or length if none.        */
+/*                                                                           */
+int find_outside(char *qscores, int from, int length, int low, int high)
+{
+#ifdef SIMD_KERNELS
+  if (low < CHAR_MIN) low = CHAR_MIN;
+  if (high > CHAR_MAX) high = CHAR_MAX;
+  if (low > high) return from < length ? from : length;
+  if (HAS_AVX2)
+  { return outside_256(qscores, from, length, (char)low, (char)high); }
+  if (HAS_SSE42)
+  { return outside_128(qscores, from, length, (char)low, (char)high); }
+#endif
+  return outside_scalar(qscores, from, length, low, high);
+}
@@ -0,0 +1,474 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   bgzf.c - read gzip and BGZF files and write BGZF files                  */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from record_reader.c to read a compressed file,   */
+/*   and from trim_bases.c and merge_fastq.c to write the output.            */
+/*   A BGZF file consists of gzip members of at most 64 KiB, each of which   */
+/*   tells its own size, so that BGZF_BLOCKS blocks are read at once and     */
+/*   (de)compressed in n_threads threads (option -j).  Any other gzip file,  */
+/*   including concatenated members, is decompressed in one thread.          */
+/*   BGZF output is written only when option -z is provided; otherwise the   */
+/*   output is written as it is.  Threads that format the output put their   */
+/*   own parts into struct text with append_text(), and the parts are then   */
+/*   written in the order of the input.                                      */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Add append_text()                                         */
+/*   Oct 17, 2026  Keep the output in memory if no file is given             */
+/*   Oct 17, 2026  Take n_threads from the caller; raise errors after jobs   */
+/*   Oct 17, 2026  Join the threads created; free the input before errors    */
+/*   Oct 17, 2026  Keep the text when it cannot be enlarged                  */
+/*                                                                           */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "defaults.h"
+#include "bgzf.h"
+
+#define SIZE_GZ_INPUT 0x10000
+#define SIZE_HEADER 18	/* header of a BGZF block with only the BC field */
+#define SIZE_FOOTER 8	/* CRC32 and ISIZE */
+
+#define BROKEN_BLOCK -1	/* in sizes[], set by a thread for an error */
+#define BROKEN_ZLIB -2
+
+void append_text(struct text *, char *, size_t);
+
+
+/**** blocks (de)compressed by one thread ****/
+struct bgzf_job
+{
+  struct gz_input *g;
+  struct bgzf_output *o;
+  int first;
+  int last;
+};
+
+static const unsigned char bgzf_eof[28] =
+{	/* an empty block at the end of a BGZF file */
+  0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00,
+  0x42, 0x43, 0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00
+};
+
+
+unsigned int little_endian(unsigned char *p, int n)
+{
+  unsigned int value = 0;
+
+  while (n-- > 0) value = (value << 8) | p[n];
+  return value;
+}
+
+
+/*                                                                           */
+/* run_bgzf_jobs()                                                           */
+/*                                                                           */
+/*   This function divides n blocks into n_threads jobs and runs them at     */
+/*   the same time.  A job does not raise an error in its thread, but marks  */
+/*   the block in sizes[], so that the error is raised by the caller.        */
+/*                                                                           */
+void run_bgzf_jobs(void *(*job)(void *), struct gz_input *g,
+                   struct bgzf_output *o, int n)
+{
+  pthread_t threads[MAX_THREADS];
+  struct bgzf_job jobs[MAX_THREADS];
+  int *sizes = g != NULL ? g->sizes : o->sizes;
+  int n_threads = g != NULL ? g->n_threads : o->n_threads;
+  int t, n_created, n_jobs = n < n_threads ? n : n_threads;
+
+  for (t = 0; t < n_jobs; t++)
+  {
+    jobs[t].g = g;
+    jobs[t].o = o;
+    jobs[t].first = n * t / n_jobs;
+    jobs[t].last = n * (t + 1) / n_jobs;
+  }
+  for (t = 1; t < n_jobs; t++)
+  { if (pthread_create(&threads[t], NULL, job, &jobs[t])) break; }
+  n_created = t;
+  if (n_created == n_jobs && n_jobs > 0) job(&jobs[0]);
+  for (t = 1; t < n_created; t++) pthread_join(threads[t], NULL);
+  if (n_created < n_jobs)
+  { ERROR_MESSAGE(227, "thread creation"); }	/* after the jobs ended */
+  for (t = 0; t < n; t++)
+  {
+    if (sizes[t] == BROKEN_ZLIB)
+    { ERROR_MESSAGE(230, "zlib initialization"); }
+    if (sizes[t] == BROKEN_BLOCK && g != NULL)
+    { ERROR_MESSAGE(230, "broken BGZF block"); }
+    if (sizes[t] == BROKEN_BLOCK)
+    { ERROR_MESSAGE(230, "BGZF compression"); }
+  }
+}
+
+
+/*                                                                           */
+/* open_gz_input()                                                           */
+/*                                                                           */
+/*   This function starts to read a gzip file from fp.  Bytes already read   */
+/*   from fp, if any, are given with peek.  The file is regarded as BGZF     */
+/*   when the first member has the BC field.                                 */
+/*                                                                           */
+struct gz_input *open_gz_input(FILE *fp, char *peek, int n_peek,
+                               int n_threads)
+{
+  struct gz_input *g;
+
+  if ((g = (struct gz_input *)calloc(1, sizeof(*g))) == NULL)
+  { ERROR_MESSAGE(226, "memory allocation for a compressed file"); }
+  g->fp = fp;
+  g->n_threads = n_threads;
+  memcpy(g->peek, peek, n_peek);
+  g->n_peek = n_peek + (int)fread(g->peek + n_peek, 1,
+                                  SIZE_HEADER - n_peek, fp);
+  g->bgzf = g->n_peek == SIZE_HEADER && (g->peek[3] & 4) &&
+            little_endian(g->peek + 10, 2) == 6 &&
+            g->peek[12] == 'B' && g->peek[13] == 'C' &&
+            little_endian(g->peek + 14, 2) == 2;
+  g->ended = 1;
+
+  if (g->bgzf)
+  {
+    g->blocks = (unsigned char *)malloc(BGZF_BLOCKS * BGZF_MAX_BLOCK);
+    g->out = (char *)malloc(BGZF_BLOCKS * BGZF_MAX_BLOCK);
+    if (g->blocks == NULL || g->out == NULL)
+    {
+      free(g->blocks); free(g->out); free(g);
+      ERROR_MESSAGE(226, "memory allocation for a compressed file");
+    }
+  }
+  else
+  {
+    if ((g->in = (unsigned char *)malloc(SIZE_GZ_INPUT)) == NULL)
+    {
+      free(g);
+      ERROR_MESSAGE(226, "memory allocation for a compressed file");
+    }
+    if (inflateInit2(&g->z, 15 + 16) != Z_OK)
+    { free(g->in); free(g); ERROR_MESSAGE(230, "zlib initialization"); }
+  }
+  return g;
+}
+
+
+void close_gz_input(struct gz_input *g)
+{
+  if (g->bgzf) { free(g->blocks); free(g->out); }
+  else { inflateEnd(&g->z); free(g->in); }
+  free(g);
+}
+
+
+/*                                                                           */
+/* rewind_gz_input()                                                         */
+/*                                                                           */
+/*   This function makes the file read again from the beginning.  It         */
+/*   returns -1 when the file cannot be rewound, e.g. a pipe.                */
+/*                                                                           */
+int rewind_gz_input(struct gz_input *g)
+{
+  if (fseek(g->fp, 0L, SEEK_SET) != 0) return -1;
+  g->n_peek = g->used_peek = 0;
+  g->eof = 0;
+  g->ended = 1;
+  g->n_blocks = g->block = g->position = 0;
+  if (!g->bgzf) { inflateReset(&g->z); g->z.avail_in = 0; }
+  return 0;
+}
+
+
+size_t read_raw(struct gz_input *g, void *buffer, size_t size)
+{	/* bytes peeked are read first */
+  size_t n = 0;
+
+  while (n < size && g->used_peek < g->n_peek)
+  { ((unsigned char *)buffer)[n++] = g->peek[g->used_peek++]; }
+  return n + fread((unsigned char *)buffer + n, 1, size - n, g->fp);
+}
+
+
+/*                                                                           */
+/* read_blocks()                                                             */
+/*                                                                           */
+/*   This function reads at most BGZF_BLOCKS blocks of a BGZF file.          */
+/*   It returns the number of blocks read.                                   */
+/*                                                                           */
+int read_blocks(struct gz_input *g)
+{
+  unsigned char *block;
+  int size;
+
+  for (g->n_blocks = 0; g->n_blocks < BGZF_BLOCKS; g->n_blocks++)
+  {
+    block = g->blocks + g->n_blocks * BGZF_MAX_BLOCK;
+    size = (int)read_raw(g, block, SIZE_HEADER);
+    if (size == 0) { g->eof = 1; break; }
+    if (size < SIZE_HEADER || block[0] != 0x1f || block[1] != 0x8b ||
+        !(block[3] & 4) || little_endian(block + 10, 2) != 6 ||
+        block[12] != 'B' || block[13] != 'C')
+    { ERROR_MESSAGE(230, "broken BGZF block"); }
+    size = (int)little_endian(block + 16, 2) + 1;
+    if (size < SIZE_HEADER + SIZE_FOOTER ||
+        read_raw(g, block + SIZE_HEADER, size - SIZE_HEADER) !=
+        (size_t)(size - SIZE_HEADER))
+    { ERROR_MESSAGE(230, "broken BGZF block"); }
+    g->sizes[g->n_blocks] = size;	/* replaced by the decompressed size */
+  }
+  g->block = g->position = 0;
+  return g->n_blocks;
+}
+
+
+void *inflate_blocks(void *arg)
+{
+  struct bgzf_job *job = (struct bgzf_job *)arg;
+  struct gz_input *g = job->g;
+  unsigned char *block;
+  char *out;
+  int i, size;
+  unsigned int size_out;
+  z_stream z;
+
+  for (i = job->first; i < job->last; i++)
+  {
+    block = g->blocks + i * BGZF_MAX_BLOCK;
+    out = g->out + i * BGZF_MAX_BLOCK;
+    size = g->sizes[i];
+    size_out = little_endian(block + size - 4, 4);
+    if (size_out > BGZF_MAX_BLOCK) { g->sizes[i] = BROKEN_BLOCK; continue; }
+
+    memset(&z, 0, sizeof(z));
+    if (inflateInit2(&z, -15) != Z_OK) { g->sizes[i] = BROKEN_ZLIB; continue; }
+    z.next_in = block + SIZE_HEADER;
+    z.avail_in = size - SIZE_HEADER - SIZE_FOOTER;
+    z.next_out = (unsigned char *)out;
+    z.avail_out = BGZF_MAX_BLOCK;
+    if (inflate(&z, Z_FINISH) != Z_STREAM_END || z.total_out != size_out ||
+        crc32(crc32(0L, Z_NULL, 0), (unsigned char *)out, size_out) !=
+        little_endian(block + size - SIZE_FOOTER, 4))
+    { g->sizes[i] = BROKEN_BLOCK; }
+    else { g->sizes[i] = (int)size_out; }
+    inflateEnd(&z);
+  }
+  return NULL;
+}
+
+
+/*                                                                           */
+/* read_gz_input()                                                           */
+/*                                                                           */
+/*   This function decompresses at most size bytes into buffer.              */
+/*   It returns the number of bytes, which is less than size only at the     */
+/*   end of the file.                                                        */
+/*                                                                           */
+size_t read_gz_input(struct gz_input *g, char *buffer, size_t size)
+{
+  size_t n = 0, m;
+  int status;
+
+  while (n < size && g->bgzf)
+  {
+    if (g->block == g->n_blocks)
+    {
+      if (g->eof || read_blocks(g) == 0) break;
+      run_bgzf_jobs(inflate_blocks, g, NULL, g->n_blocks);
+      continue;
+    }
+    m = (size_t)(g->sizes[g->block] - g->position);
+    if (m > size - n) m = size - n;
+    memcpy(buffer + n, g->out + g->block * BGZF_MAX_BLOCK + g->position, m);
+    n += m;
+    if ((g->position += (int)m) == g->sizes[g->block])
+    { g->block++; g->position = 0; }
+  }
+  if (g->bgzf) return n;
+
+  g->z.next_out = (unsigned char *)buffer;
+  g->z.avail_out = (unsigned int)size;
+  while (g->z.avail_out > 0 && !g->eof)
+  {
+    if (g->z.avail_in == 0)
+    {
+      g->z.next_in = g->in;
+      g->z.avail_in = (unsigned int)read_raw(g, g->in, SIZE_GZ_INPUT);
+      if (g->z.avail_in == 0)
+      {
+        if (!g->ended) { ERROR_MESSAGE(230, "unexpected end of gzip file"); }
+        g->eof = 1;
+        break;
+      }
+    }
+    status = inflate(&g->z, Z_NO_FLUSH);
+    if (status == Z_STREAM_END)
+    {	/* another member may follow */
+      inflateReset(&g->z);
+      g->ended = 1;
+    }
+    else if (status == Z_OK) { g->ended = 0; }
+    else { ERROR_MESSAGE(230, "broken gzip file"); }
+  }
+  return size - g->z.avail_out;
+}
+
+
+/*                                                                           */
+/* open_output()                                                             */
+/*                                                                           */
+/*   This function prepares the output into fp, compressed into BGZF if      */
+/*   compressing is 1.  If fp is NULL, the output is kept in o->text, which  */
+/*   the caller may read and empty.                                          */
+/*                                                                           */
+struct bgzf_output *open_output(FILE *fp, short int compressing,
+                                int n_threads)
+{
+  struct bgzf_output *o;
+
+  if ((o = (struct bgzf_output *)calloc(1, sizeof(*o))) == NULL)
+  { ERROR_MESSAGE(226, "memory allocation for the output"); }
+  o->fp = fp;
+  o->compressing = compressing;
+  o->n_threads = n_threads;
+  if (compressing)
+  {
+    o->data = (char *)malloc(BGZF_BLOCKS * BGZF_DATA);
+    o->blocks = (unsigned char *)malloc(BGZF_BLOCKS * BGZF_MAX_BLOCK);
+    if (o->data == NULL || o->blocks == NULL)
+    { ERROR_MESSAGE(226, "memory allocation for the output"); }
+  }
+  return o;
+}
+
+
+void *deflate_blocks(void *arg)
+{
+  struct bgzf_job *job = (struct bgzf_job *)arg;
+  struct bgzf_output *o = job->o;
+  unsigned char *block;
+  char *data;
+  int i, size_data, size;
+  unsigned long int crc;
+  z_stream z;
+
+  for (i = job->first; i < job->last; i++)
+  {
+    block = o->blocks + i * BGZF_MAX_BLOCK;
+    data = o->data + i * BGZF_DATA;
+    size_data = (int)(o->size - i * BGZF_DATA);
+    if (size_data > BGZF_DATA) size_data = BGZF_DATA;
+
+    memset(&z, 0, sizeof(z));
+    if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+    { o->sizes[i] = BROKEN_ZLIB; continue; }
+    z.next_in = (unsigned char *)data;
+    z.avail_in = size_data;
+    z.next_out = block + SIZE_HEADER;
+    z.avail_out = BGZF_MAX_BLOCK - SIZE_HEADER - SIZE_FOOTER;
+    if (deflate(&z, Z_FINISH) != Z_STREAM_END)
+    { deflateEnd(&z); o->sizes[i] = BROKEN_BLOCK; continue; }
+    size = SIZE_HEADER + (int)z.total_out + SIZE_FOOTER;
+    deflateEnd(&z);
+
+    memcpy(block, bgzf_eof, SIZE_HEADER);
+    block[16] = (unsigned char)((size - 1) & 0xff);
+    block[17] = (unsigned char)((size - 1) >> 8);
+    crc = crc32(crc32(0L, Z_NULL, 0), (unsigned char *)data, size_data);
+    block[size - 8] = (unsigned char)(crc & 0xff);
+    block[size - 7] = (unsigned char)((crc >> 8) & 0xff);
+    block[size - 6] = (unsigned char)((crc >> 16) & 0xff);
+    block[size - 5] = (unsigned char)((crc >> 24) & 0xff);
+    block[size - 4] = (unsigned char)(size_data & 0xff);
+    block[size - 3] = (unsigned char)((size_data >> 8) & 0xff);
+    block[size - 2] = block[size - 1] = 0;
+    o->sizes[i] = size;
+  }
+  return NULL;
+}
+
+
+void flush_output(struct bgzf_output *o)
+{
+  int i, n = (int)((o->size + BGZF_DATA - 1) / BGZF_DATA);
+
+  run_bgzf_jobs(deflate_blocks, NULL, o, n);
+  for (i = 0; i < n; i++)
+  { fwrite(o->blocks + i * BGZF_MAX_BLOCK, 1, o->sizes[i], o->fp); }
+  o->size = 0;
+}
+
+
+/*                                                                           */
+/* write_output()                                                            */
+/*                                                                           */
+/*   This function writes size bytes of data.  When compressing, the data    */
+/*   are kept until BGZF_BLOCKS blocks are filled.                           */
+/*                                                                           */
+void write_output(struct bgzf_output *o, char *data, size_t size)
+{
+  size_t m;
+
+  if (o->fp == NULL) { append_text(&o->text, data, size); return; }
+  if (!o->compressing) { fwrite(data, 1, size, o->fp); return; }
+  while (size > 0)
+  {
+    m = BGZF_BLOCKS * BGZF_DATA - o->size;
+    if (m > size) m = size;
+    memcpy(o->data + o->size, data, m);
+    o->size += m;
+    data += m;
+    size -= m;
+    if (o->size == BGZF_BLOCKS * BGZF_DATA) flush_output(o);
+  }
+}
+
+
+void close_output(struct bgzf_output *o)
+{
+  if (o->compressing)
+  {
+    if (o->size > 0) flush_output(o);
+    fwrite(bgzf_eof, 1, sizeof(bgzf_eof), o->fp);
+    free(o->data);
+    free(o->blocks);
+  }
+  if (o->fp != NULL) fflush(o->fp);
+  free(o->text.data);
+  free(o);
+}
+
+
+/*                                                                           */
+/* append_text()                                                             */
+/*                                                                           */
+/*   This function appends size bytes of data to a text, which is enlarged   */
+/*   as needed.                                                              */
+/*                                                                           */
+void append_text(struct text *t, char *data, size_t size)
+{
+  size_t size_buffer = t->size_buffer;
+  char *buffer;
+
+  if (t->size + size > size_buffer)
+  {
+    if (size_buffer == 0) size_buffer = 0x10000;
+    while (t->size + size > size_buffer) size_buffer *= 2;
+    buffer = (char *)realloc(t->data, size_buffer);
+    if (buffer == NULL)	/* the text is kept until it is freed */
+    { ERROR_MESSAGE(226, "memory allocation for the output"); }
+    t->data = buffer;
+    t->size_buffer = size_buffer;
+  }
+  memcpy(t->data + t->size, data, size);
+  t->size += size;
+}
@@ -0,0 +1,72 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   bgzf.h - header file for bgzf.c                                         */
+/*                                                                           */
+/* SYNOPSIS                                                                  */
+/*   #include <zlib.h>                                                       */
+/*   #include "bgzf.h"                                                       */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This is a header file for bgzf.c, in which gzip and BGZF files are      */
+/*   read and BGZF files are written.                                        */
+/*   Struct text keeps the output of a thread, which is written in order.    */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Each input and output has its own n_threads               */
+/*                                                                           */
+
+
+#define BGZF_BLOCKS 64
+	/* number of BGZF blocks (de)compressed at once */
+
+#define BGZF_MAX_BLOCK 0x10000
+	/* maximum size of a BGZF block, compressed or not */
+
+#define BGZF_DATA 0xff00
+	/* bytes compressed into a BGZF block */
+
+/**** a gzip or BGZF file being read ****/
+struct gz_input
+{
+  FILE *fp;
+  unsigned char peek[18];	/* bytes read to know the format */
+  int n_peek;
+  int used_peek;		/* bytes of peek read again */
+  short int bgzf;		/* 1: BGZF; 0: other gzip */
+  short int eof;
+  short int ended;		/* no gzip member is being read */
+  int n_threads;		/* to decompress BGZF blocks */
+  z_stream z;			/* for other gzip */
+  unsigned char *in;		/* compressed bytes for other gzip */
+  unsigned char *blocks;	/* BGZF_BLOCKS compressed BGZF blocks */
+  char *out;			/* decompressed bytes of the blocks */
+  int sizes[BGZF_BLOCKS];	/* decompressed bytes of each block */
+  int n_blocks;
+  int block;			/* the block being read */
+  int position;			/* next byte to be read in the block */
+};
+
+/**** bytes formatted by a thread, to be written later in order ****/
+struct text
+{
+  char *data;
+  size_t size;			/* bytes in data */
+  size_t size_buffer;		/* bytes allocated */
+};
+
+/**** a file written as it is, or compressed into BGZF ****/
+struct bgzf_output
+{
+  FILE *fp;			/* NULL to keep the output in text */
+  short int compressing;
+  int n_threads;		/* to compress BGZF blocks */
+  char *data;			/* BGZF_BLOCKS blocks to be compressed */
+  size_t size;			/* bytes in data */
+  unsigned char *blocks;	/* compressed blocks */
+  int sizes[BGZF_BLOCKS];
+  struct text text;		/* the output kept in memory */
+};
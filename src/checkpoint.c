@@ -0,0 +1,342 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   checkpoint.c - save the state of a walk and resume it (-F, -R, -E)      */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from read_reads.c when option -F is provided.     */
+/*   At the end of every pass over the reads that leaves a walker active,    */
+/*   the state of the walk is written into the checkpoint file: the          */
+/*   counters of option -T and, for each walker, the seed, the bases         */
+/*   assembled, where the mate or a circle was searched for, and the         */
+/*   nominee table.  It is written into a temporary file first and renamed,  */
+/*   so that a walk killed while it is written leaves the last checkpoint.   */
+/*   With option -R, a walk whose checkpoint file exists starts from the     */
+/*   pass after the checkpoint: the bases assembled are printed again, the   */
+/*   walkers already finished are finished with the same codes, and the      */
+/*   others walk on as if the walk had not been stopped.  Without the file   */
+/*   the walk starts from the seeds, so a failed job can be rerun with the   */
+/*   same options.  The last checkpoint is written when the walk is over.    */
+/*   The walk should have the same seeds, parameters, and reads as the one   */
+/*   that wrote the file.  The reads dropped with option -D are not saved,   */
+/*   so the options cannot be used with -D.  The rows of option -T are       */
+/*   written from the resumed pass, with the counters continued.             */
+/*   With option -E, the reads may have been appended to the file since the  */
+/*   checkpoint, e.g. another lane of the library, and the walkers that      */
+/*   were finished as no extension had the depth walk again.  If the walk    */
+/*   was over, their nominee tables already hold the reads before those      */
+/*   appended, so the first pass reads only the reads appended: from the     */
+/*   first one after the reads stored or indexed (options -a and -k), or     */
+/*   from the end of the file of reads unless it is compressed.  The         */
+/*   passes after it read all the reads as usual.                            */
+/*                                                                           */
+/* FILE FORMAT                                                               */
+/*   CHECKPOINT_MAGIC, the parameters, the size of the file of reads, the    */
+/*   number of reads stored or indexed, the counters of option -T,           */
+/*   followed by each walker: its state, the seed, the bases assembled,      */
+/*   and the nominee table.  Integers are written in the byte order of the   */
+/*   machine.                                                                */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Extend a walk on reads appended to the file (option -E)   */
+/*   Oct 17, 2026  Keep the checkpoint file on the context while it is read  */
+/*                                                                           */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "defaults.h"
+#include "grepwalk.h"
+#include "examine_reads.h"
+#include "record_reader.h"
+
+#define CHECKPOINT_MAGIC "GrepWalkCheck2\n"
+#define SIZE_MAGIC 16
+#define N_CHECKED 10
+
+
+long int size_of_file(FILE *);
+int print_bases(struct walker *, char *);
+void finish_walker(struct walker *, int);
+void init_extending_seq_table(struct walker *);
+struct slot *find_extending_seq(struct walker *, char *);
+int add_extending_seq(struct walker *, struct slot *, char *);
+void build_seed_matcher(struct walker *);
+void seek_records(struct record_reader *, long int);
+
+
+/*                                                                           */
+/* checked_values()                                                          */
+/*                                                                           */
+/*   This function sets the values that should be the same for a walk and    */
+/*   its checkpoint.                                                         */
+/*                                                                           */
+void checked_values(struct grepwalk *gw, long int *values)
+{
+  values[0] = gw->window;
+  values[1] = gw->slide;
+  values[2] = gw->minimum_qscore;
+  values[3] = gw->strand_depth;
+  values[4] = gw->maximum_length;
+  values[5] = gw->nondirec;
+  values[6] = gw->keep_walking;
+  values[7] = gw->bidirectional;
+  values[8] = gw->circular;
+  values[9] = gw->n_walkers;
+}
+
+
+long int size_of_reads(char *name_fastq)
+{
+  long int size = -1;	/* unknown, e.g. the standard input */
+  FILE *fp;
+
+  if ((fp = fopen(name_fastq, "r")) != NULL)
+  { size = size_of_file(fp); fclose(fp); }
+  return size;
+}
+
+
+long int number_of_reads(struct grepwalk *gw)
+{
+  if (gw->store != NULL) return (long int)gw->store->n_reads;
+  if (gw->index != NULL) return (long int)gw->index->n_reads;
+  return -1;
+}
+
+
+int save_walker(struct walker *w, FILE *fp)
+{
+  return
+    fwrite(&w->finished, sizeof(short int), 1, fp) != 1 ||
+    fwrite(&w->active, sizeof(short int), 1, fp) != 1 ||
+    fwrite(&w->starved, sizeof(short int), 1, fp) != 1 ||
+    fwrite(&w->length_assembled, sizeof(long int), 1, fp) != 1 ||
+    fwrite(&w->met, sizeof(long int), 1, fp) != 1 ||
+    fwrite(&w->length_checked, sizeof(long int), 1, fp) != 1 ||
+    fwrite(&w->hits_plus, sizeof(long int), 1, fp) != 1 ||
+    fwrite(&w->hits_minus, sizeof(long int), 1, fp) != 1 ||
+    fwrite(&w->rejected, sizeof(long int), 1, fp) != 1 ||
+    fwrite(&w->length_contig, sizeof(long int), 1, fp) != 1 ||
+    fwrite(&w->n_table, sizeof(int), 1, fp) != 1 ||
+    fwrite(w->seed, 1, MAX_CHAR, fp) != MAX_CHAR ||
+    fwrite(w->contig, 1, w->length_contig, fp)
+      != (size_t)w->length_contig ||
+    fwrite(w->table, sizeof(struct list), w->n_table, fp)
+      != (size_t)w->n_table;
+}
+
+
+/*                                                                           */
+/* write_checkpoint()                                                        */
+/*                                                                           */
+/*   This function is called at the end of a pass that leaves a walker       */
+/*   active and when the walk is over, and replaces the checkpoint file.     */
+/*                                                                           */
+int write_checkpoint(struct grepwalk *gw, char *name_fastq)
+{
+  int i;
+  long int values[N_CHECKED], size, n_reads;
+  char magic[SIZE_MAGIC] = CHECKPOINT_MAGIC;
+  char name_tmp[MAX_CHAR + 4];
+  struct walk_stats *t = &gw->stats;
+  FILE *fp;
+
+  checked_values(gw, values);
+  size = size_of_reads(name_fastq);
+  n_reads = number_of_reads(gw);
+  sprintf(name_tmp, "%s.tmp", gw->checkpoint);
+  if ((fp = fopen(name_tmp, "wb")) == NULL)
+  { ERROR_MESSAGE(232, name_tmp); }
+  if (fwrite(magic, 1, SIZE_MAGIC, fp) != SIZE_MAGIC ||
+      fwrite(values, sizeof(long int), N_CHECKED, fp) != N_CHECKED ||
+      fwrite(&size, sizeof(long int), 1, fp) != 1 ||
+      fwrite(&n_reads, sizeof(long int), 1, fp) != 1 ||
+      fwrite(&t->n_passes, sizeof(int), 1, fp) != 1 ||
+      fwrite(&t->n_scanned, sizeof(long int), 1, fp) != 1 ||
+      fwrite(&t->bytes_scanned, sizeof(long int), 1, fp) != 1 ||
+      fwrite(&t->n_steps, sizeof(long int), 1, fp) != 1)
+  { fclose(fp); ERROR_MESSAGE(232, name_tmp); }
+  for (i = 0; i < gw->n_walkers; i++)
+  {
+    if (save_walker(gw->walkers + i, fp))
+    { fclose(fp); ERROR_MESSAGE(232, name_tmp); }
+  }
+  if (fclose(fp) != 0 || rename(name_tmp, gw->checkpoint) != 0)
+  { ERROR_MESSAGE(232, gw->checkpoint); }
+  return EXIT_SUCCESS;
+}
+
+
+/*                                                                           */
+/* load_walker()                                                             */
+/*                                                                           */
+/*   This function restores a walker from the checkpoint file.  The bases    */
+/*   assembled are left in w->contig to be printed by replay_walker().       */
+/*   It returns 1 if the file is broken or was written from other seeds.     */
+/*                                                                           */
+int load_walker(struct walker *w, FILE *fp)
+{
+  int i, n_table;
+  char seed[MAX_CHAR];
+  struct list entry;
+
+  if (fread(&w->finished, sizeof(short int), 1, fp) != 1 ||
+      fread(&w->active, sizeof(short int), 1, fp) != 1 ||
+      fread(&w->starved, sizeof(short int), 1, fp) != 1 ||
+      fread(&w->length_assembled, sizeof(long int), 1, fp) != 1 ||
+      fread(&w->met, sizeof(long int), 1, fp) != 1 ||
+      fread(&w->length_checked, sizeof(long int), 1, fp) != 1 ||
+      fread(&w->hits_plus, sizeof(long int), 1, fp) != 1 ||
+      fread(&w->hits_minus, sizeof(long int), 1, fp) != 1 ||
+      fread(&w->rejected, sizeof(long int), 1, fp) != 1 ||
+      fread(&w->length_contig, sizeof(long int), 1, fp) != 1 ||
+      fread(&n_table, sizeof(int), 1, fp) != 1 ||
+      fread(seed, 1, MAX_CHAR, fp) != MAX_CHAR ||
+      w->length_contig < w->length_seed || n_table < 0 ||
+      memchr(seed, '\0', MAX_CHAR) == NULL)
+  { return 1; }
+
+  w->size_contig = w->length_contig + MAX_CHAR;
+  free(w->contig);
+  if ((w->contig = (char *)malloc(w->size_contig)) == NULL)
+  { ERROR_MESSAGE(226, "memory allocation for a checkpoint"); }
+  if (fread(w->contig, 1, w->length_contig, fp) != (size_t)w->length_contig)
+  { return 1; }
+  w->contig[w->length_contig] = '\0';
+  if (memcmp(w->contig, w->seed, w->length_seed) != 0) return 1;
+	/* the bases assembled begin with the initial seed */
+  strcpy(w->seed, seed);
+  build_seed_matcher(w);
+
+  init_extending_seq_table(w);
+  for (i = 0; i < n_table; i++)
+  {
+    if (fread(&entry, sizeof(struct list), 1, fp) != 1) return 1;
+    entry.extending_sequence[MAX_LEN_SEQ - 1] = '\0';
+    w->strand = 1;
+    add_extending_seq(w, find_extending_seq(w, entry.extending_sequence),
+                      entry.extending_sequence);
+    w->table[i] = entry;
+  }
+  return 0;
+}
+
+
+/*                                                                           */
+/* extend_walkers()                                                          */
+/*                                                                           */
+/*   This function is called with option -E after the walkers are loaded.    */
+/*   The walkers finished as no extension had the depth walk again.  If no   */
+/*   walker was active, the first pass starts from the first read appended   */
+/*   since the checkpoint, as far as it is known; otherwise the nominee      */
+/*   tables of those walkers are emptied to count all the reads again.       */
+/*                                                                           */
+void extend_walkers(struct grepwalk *gw, long int size, long int n_reads)
+{
+  int i, over = 1;
+  struct walker *w;
+
+  for (i = 0; i < gw->n_walkers; i++) if (gw->walkers[i].active) over = 0;
+  for (i = 0; i < gw->n_walkers; i++)
+  {
+    w = gw->walkers + i;
+    if (!w->starved) continue;
+    w->starved = w->finished = 0;
+    w->active = 1;
+    if (!over) init_extending_seq_table(w);
+  }
+  if (!over) return;
+  if (gw->store != NULL || gw->index != NULL)
+  { if (n_reads >= 0) gw->first_read = n_reads; }
+  else if (gw->fastq->gz == NULL && size > 0)
+  { seek_records(gw->fastq, size); }
+}
+
+
+/*                                                                           */
+/* load_checkpoint()                                                         */
+/*                                                                           */
+/*   This function is called from read_reads() with option -R or -E before   */
+/*   the walk starts.  It returns 1 when the walk is resumed from the        */
+/*   checkpoint file, or 0 if the file does not exist.                       */
+/*                                                                           */
+int load_checkpoint(struct grepwalk *gw, char *name_fastq)
+{
+  int i;
+  long int values[N_CHECKED], saved[N_CHECKED], size, n_reads;
+  char magic[SIZE_MAGIC];
+  struct walk_stats *t = &gw->stats;
+  FILE *fp;
+
+  if ((fp = fopen(gw->checkpoint, "rb")) == NULL) return 0;
+  gw->checkpoint_file = fp;	/* closed by free_grepwalk() after an error */
+  checked_values(gw, values);
+  if (fread(magic, 1, SIZE_MAGIC, fp) != SIZE_MAGIC ||
+      strncmp(magic, CHECKPOINT_MAGIC, SIZE_MAGIC) ||
+      fread(saved, sizeof(long int), N_CHECKED, fp) != N_CHECKED ||
+      fread(&size, sizeof(long int), 1, fp) != 1 ||
+      fread(&n_reads, sizeof(long int), 1, fp) != 1)
+  { ERROR_MESSAGE(232, gw->checkpoint); }
+  if (memcmp(values, saved, sizeof(values)) != 0 ||
+      (gw->extending ? size_of_reads(name_fastq) < size :
+                       size_of_reads(name_fastq) != size))
+  {
+    fail_walk(232, "The checkpoint does not match the walk: %s",
+              gw->checkpoint);
+  }
+  if (fread(&t->n_passes, sizeof(int), 1, fp) != 1 ||
+      fread(&t->n_scanned, sizeof(long int), 1, fp) != 1 ||
+      fread(&t->bytes_scanned, sizeof(long int), 1, fp) != 1 ||
+      fread(&t->n_steps, sizeof(long int), 1, fp) != 1)
+  { ERROR_MESSAGE(232, gw->checkpoint); }
+  for (i = 0; i < gw->n_walkers; i++)
+  {
+    if (load_walker(gw->walkers + i, fp))
+    {
+      fail_walk(232, "The checkpoint does not match the walk: %s",
+                gw->checkpoint);
+    }
+  }
+  fclose(fp);
+  gw->checkpoint_file = NULL;
+  if (gw->extending) extend_walkers(gw, size, n_reads);
+  return 1;
+}
+
+
+/*                                                                           */
+/* replay_walker()                                                           */
+/*                                                                           */
+/*   This function prints the bases assembled by a walker loaded from the    */
+/*   checkpoint file, after its FASTA header, as they were printed before,   */
+/*   and finishes the walker if it was finished.                             */
+/*                                                                           */
+void replay_walker(struct walker *w)
+{
+  char *bases = w->contig, chunk[MAX_CHAR];
+  long int i, length = w->length_contig;
+  int l = w->gw->n_columns < MAX_CHAR / 2 ? w->gw->n_columns : MAX_CHAR / 2;
+
+  if ((w->contig = (char *)malloc(w->size_contig)) == NULL)
+  {
+    w->contig = bases;
+    ERROR_MESSAGE(226, "memory allocation for a checkpoint");
+  }
+	/* large enough not to be reallocated until bases are freed */
+  w->length_contig = 0;
+  w->seq_buffer[0] = '\0';
+  for (i = 0; i < length; i += l)
+  {
+    if (length - i < l) l = (int)(length - i);
+    memcpy(chunk, bases + i, l);
+    chunk[l] = '\0';
+    print_bases(w, chunk);
+  }
+  free(bases);
+  if (w->finished) finish_walker(w, w->finished);
+}
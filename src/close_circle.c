@@ -0,0 +1,128 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   close_circle.c - stop a walk when it goes around a circular genome      */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from read_reads.c and scan_reads.c when option    */
+/*   -C is provided.  A walker without a mate (see option -B) keeps the      */
+/*   bases it has assembled, and the positions of their k-mers in a hash     */
+/*   table, where k is the window minus the sliding size, i.e. the length    */
+/*   of the seed moved by check_read().  When the sequence is extended, the  */
+/*   last k bases, which are the new seed, are looked up among the k-mers    */
+/*   that do not overlap them.  If they are found, the walk has come back    */
+/*   to bases it has assembled: the bases after the match are the same as    */
+/*   those the walk would assemble again.  The sequence is cut before the    */
+/*   last k bases and the bases before them that are the same as those       */
+/*   before the match, and the walk is finished with code 2.  A walk from a  */
+/*   seed on a circular genome thus stops with one circle from the seed,     */
+/*   and so does one caught in a repeat longer than k bases.  With option    */
+/*   -D, the reads around the seed may be dropped before the circle is       */
+/*   closed, and then the walk stops as it does without -C.                  */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*                                                                           */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "defaults.h"
+#include "grepwalk.h"
+#include "examine_reads.h"
+
+#define MIN_BITS_KMERS 12
+
+
+void finish_walker(struct walker *, int);
+
+
+uint64_t hash_kmer(char *kmer, int k)
+{	/* T, C, A, and G are two bits apart; others are told by memcmp() */
+  uint64_t code = 0;
+  int i;
+
+  for (i = 0; i < k && i < 32; i++)
+  { code = (code << 2) | (uint64_t)((kmer[i] >> 1) & 3); }
+  return code * UINT64_C(0x9E3779B97F4A7C15);
+}
+
+
+void put_kmer(struct walker *w, long int position, int k)
+{
+  uint64_t i, mask = ((uint64_t)1 << w->bits_kmers) - 1;
+
+  for (i = hash_kmer(w->contig + position, k) >> (64 - w->bits_kmers);
+       w->kmers[i] != 0; i = (i + 1) & mask) ;
+  w->kmers[i] = position + 1;
+}
+
+
+/*                                                                           */
+/* hash_kmers()                                                              */
+/*                                                                           */
+/*   This function puts the k-mers starting before position to the table,    */
+/*   which is doubled when it is half full.                                  */
+/*                                                                           */
+void hash_kmers(struct walker *w, long int position, int k)
+{
+  long int i;
+
+  if (2 * position > ((long int)1 << w->bits_kmers))
+  {
+    free(w->kmers);
+    if (w->bits_kmers < MIN_BITS_KMERS) w->bits_kmers = MIN_BITS_KMERS;
+    while (2 * position > ((long int)1 << w->bits_kmers)) w->bits_kmers++;
+    w->kmers = (long int *)calloc((size_t)1 << w->bits_kmers,
+                                  sizeof(long int));
+    if (w->kmers == NULL)
+    { ERROR_MESSAGE(226, "memory allocation for the k-mers (-C)"); }
+    w->n_kmers = 0;
+  }
+  for (i = w->n_kmers; i < position; i++) put_kmer(w, i, k);
+  w->n_kmers = position;
+}
+
+
+/*                                                                           */
+/* close_circle()                                                            */
+/*                                                                           */
+/*   This function is called whenever a walker may have extended the         */
+/*   sequence.  It returns 1 when the walker has come back to bases it has   */
+/*   assembled and is finished, otherwise 0.                                 */
+/*                                                                           */
+int close_circle(struct walker *w)
+{
+  struct grepwalk *gw = w->gw;
+  int k = gw->window - gw->slide;
+  long int tail, found = -1, p, d;
+  uint64_t i, mask;
+
+  if (!gw->circular || w->mate >= 0 || !w->active) return 0;
+  if (w->length_checked == w->length_contig) return 0;
+  w->length_checked = w->length_contig;
+  tail = w->length_contig - k;
+  if (tail < k) return 0;
+  hash_kmers(w, tail - k + 1, k);	/* those not overlapping the tail */
+
+  mask = ((uint64_t)1 << w->bits_kmers) - 1;
+  for (i = hash_kmer(w->contig + tail, k) >> (64 - w->bits_kmers);
+       w->kmers[i] != 0; i = (i + 1) & mask)
+  {
+    p = w->kmers[i] - 1;
+    if ((found < 0 || p < found) &&
+        memcmp(w->contig + p, w->contig + tail, (size_t)k) == 0)
+    { found = p; }
+  }
+  if (found < 0) return 0;
+
+  for (d = 0; d < found &&
+              w->contig[found - 1 - d] == w->contig[tail - 1 - d]; d++) ;
+  w->length_contig = tail - d;
+  w->contig[w->length_contig] = '\0';
+  finish_walker(w, 2);
+  return 1;
+}
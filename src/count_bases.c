@@ -8,6 +8,11 @@
 /* DESCRIPTION                                                               */
 /*   This module is called from grepwalk.c                                   */
 /*   when option -u is provided.                                             */
+/*   Entries are taken in batches, and each of the n_threads threads         */
+/*   counts its own part of a batch into its own counters, which are         */
+/*   summed up at the end.  Quality scores are compared 32 or 16 at a time   */
+/*   by count_at_least() of base_kernels.c.  With option -Q, quality scores  */
+/*   by cycle, read lengths, and G+C contents are counted in the same pass.  */
 /*                                                                           */
 /* OPTIONS                                                                   */
 /*   Not applicable.                                                         */
@@ -18,21 +23,196 @@
 /* HISTORY                                                                   */
 /*   Oct 08, 2014  Add count_reads_bases() to merge_fastq.c                  */
 /*   May 13, 2015  Move count_reads_bases() into diverged trim_bases.c       */
+/*   Oct 17, 2026  Read entries with record_reader.c                         */
+/*   Oct 17, 2026  Count in threads eight scores at a time; support -Q       */
+/*   Oct 17, 2026  Count the scores with count_at_least() of base_kernels.c  */
 /*                                                                           */
 
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include "defaults.h"
+#include "record_reader.h"
 
-#define MAX_CHAR 0x400
 #define CODE_TO_SCORE (short int)(-33)
-#define ERROR_MESSAGE(code, string) \
-  fprintf(stderr, "GrepWalk error %d: %s\n", (code), (string)); \
-  exit((code));
-  
+#define SIZE_BATCH 0x1000
+#define N_QSCORES 94	/* bins of scores from 0 ('!') to 93 ('~') */
+
 
 extern int minimum_qscore;
+extern int n_threads;
+extern short int reporting;
+
+struct record_reader *open_records(char *, int);
+int next_records(struct record_reader *, struct record *, int);
+void close_records(struct record_reader *);
+int count_at_least(char *, int, int);
+
+
+/**** counters of one thread ****/
+struct counts
+{
+  struct record *records;
+  int first;
+  int last;
+  int broken;			/* a fasta entry is found */
+  unsigned long int count_read;
+  unsigned long int count_base;
+  unsigned long int count_allb;
+  unsigned long int count_gc;		/* G or C */
+  unsigned long int count_tcag;		/* T, C, A, or G */
+  unsigned long int *lengths;		/* MAX_CHAR bins; the last for longer */
+  unsigned long int *gc_reads;		/* reads by G+C percent, 0 to 100 */
+  unsigned long int *cycles;		/* [cycle * N_QSCORES + score] */
+};
+
+
+struct counts counts[MAX_THREADS];
+
+
+/*                                                                           */
+/* report_record()                                                           */
+/*                                                                           */
+/*   This function counts the length, the G+C content, and the quality       */
+/*   scores by cycle of an entry for option -Q.  Cycles beyond MAX_CHAR are  */
+/*   not counted.                                                            */
+/*                                                                           */
+void report_record(struct counts *c, struct record *r)
+{
+  int i, score, gc = 0, tcag = 0;
+  int length = r->length_qscores < MAX_CHAR ? r->length_qscores : MAX_CHAR;
+
+  c->lengths[r->length_sequence < MAX_CHAR ?
+             r->length_sequence : MAX_CHAR - 1]++;
+  for (i = 0; i < r->length_sequence; i++)
+  {
+    switch (r->sequence[i])
+    {
+      case 'G': case 'C': case 'g': case 'c': gc++; tcag++; break;
+      case 'T': case 'A': case 't': case 'a': tcag++;
+    }
+  }
+  c->count_gc += (unsigned long int)gc;
+  c->count_tcag += (unsigned long int)tcag;
+  if (tcag > 0) c->gc_reads[(200 * gc + tcag) / (2 * tcag)]++;
+
+  for (i = 0; i < length; i++)
+  {
+    score = (int)r->qscores[i] + (int)CODE_TO_SCORE;
+    if (score < 0) score = 0;
+    if (score >= N_QSCORES) score = N_QSCORES - 1;
+    c->cycles[i * N_QSCORES + score]++;
+  }
+}
+
+
+void *count_slice(void *arg)
+{
+  struct counts *c = (struct counts *)arg;
+  struct record *r;
+  int i;
+
+  for (i = c->first; i < c->last; i++)
+  {
+    r = c->records + i;
+    if (r->qscores == NULL)	/* a fasta entry has no 4th line */
+    { c->broken = 1; return NULL; }
+    c->count_allb += (unsigned long int)r->length_qscores;
+    c->count_base += (unsigned long int)count_at_least(r->qscores,
+                       r->length_qscores, minimum_qscore - CODE_TO_SCORE);
+    c->count_read++;
+    if (reporting) report_record(c, r);
+  }
+  return NULL;
+}
+
+
+/*                                                                           */
+/* count_batch()                                                             */
+/*                                                                           */
+/*   This function divides n entries into n_threads slices and counts them   */
+/*   at the same time.  It returns 1 if a fasta entry is found.              */
+/*                                                                           */
+int count_batch(struct record *records, int n)
+{
+  pthread_t threads[MAX_THREADS];
+  int size = (n + n_threads - 1) / n_threads;
+  int t, broken = 0;
+
+  for (t = 0; t < n_threads; t++)
+  {
+    counts[t].records = records;
+    counts[t].first = t * size < n ? t * size : n;
+    counts[t].last = (t + 1) * size < n ? (t + 1) * size : n;
+  }
+  for (t = 1; t < n_threads; t++)
+  {
+    if (pthread_create(&threads[t], NULL, count_slice, &counts[t]))
+    { ERROR_MESSAGE(227, "thread creation"); }
+  }
+  count_slice(&counts[0]);
+  for (t = 1; t < n_threads; t++) pthread_join(threads[t], NULL);
+  for (t = 0; t < n_threads; t++) broken |= counts[t].broken;
+  return broken;
+}
+
+
+/*                                                                           */
+/* print_report()                                                            */
+/*                                                                           */
+/*   This function prints the counts of option -Q, summed up in counts[0],   */
+/*   onto the standard output in three tab-separated tables, each of which   */
+/*   begins with a line of column names beginning with '#'.                  */
+/*                                                                           */
+void print_report(struct counts *c)
+{
+  int i, j, max_cycle = 0, max_score = 0;
+  unsigned long int n, sum;
+
+  fprintf(stdout, "#length\treads\n");
+  for (i = 0; i < MAX_CHAR; i++)
+  {
+    if (c->lengths[i] > 0)
+    {
+      fprintf(stdout, "%d%s\t%lu\n",
+              i, i == MAX_CHAR - 1 ? "+" : "", c->lengths[i]);
+    }
+  }
+
+  fprintf(stdout, "#GC%%\treads\n");
+  for (i = 0; i <= 100; i++) fprintf(stdout, "%d\t%lu\n", i, c->gc_reads[i]);
+  fprintf(stdout, "total\t%.2f\n", c->count_tcag > 0 ?
+          100.0 * (double)c->count_gc / (double)c->count_tcag : 0.0);
+
+  for (i = 0; i < MAX_CHAR; i++)
+  {
+    for (j = 0; j < N_QSCORES; j++)
+    {
+      if (c->cycles[i * N_QSCORES + j] > 0)
+      {
+        max_cycle = i + 1;
+        if (j > max_score) max_score = j;
+      }
+    }
+  }
+  fprintf(stdout, "#cycle\tmean");
+  for (j = 0; j <= max_score; j++) fprintf(stdout, "\tQ%d", j);
+  fputc('\n', stdout);
+  for (i = 0; i < max_cycle; i++)
+  {
+    for (n = sum = 0, j = 0; j <= max_score; j++)
+    {
+      n += c->cycles[i * N_QSCORES + j];
+      sum += c->cycles[i * N_QSCORES + j] * (unsigned long int)j;
+    }
+    fprintf(stdout, "%d\t%.2f", i + 1, n > 0 ? (double)sum / (double)n : 0.0);
+    for (j = 0; j <= max_score; j++)
+    { fprintf(stdout, "\t%lu", c->cycles[i * N_QSCORES + j]); }
+    fputc('\n', stdout);
+  }
+}
 
 
 /*                                                                           */
@@ -46,40 +226,56 @@ extern int minimum_qscore;
 /*   The minimum score can be changed by using option -q.                    */
 /*   Bases that have no less than the minimal socre are counted up.          */
 /*   Numbers of reads, high-quality bases, and all bases are finally         */
-/*   printed onto the standard output.                                       */
+/*   printed onto the standard output, followed by the report of option -Q.  */
 /*                                                                           */
 int count_reads_bases(char *name_fastq)
 {
-  int i, l;
-  unsigned long int count_read = 0;
-  unsigned long int count_base = 0;
-  unsigned long int count_allb = 0;
-  char line[MAX_CHAR];
-  FILE *fastq;
-
-  if ((fastq = fopen(name_fastq, "r")) == NULL)
+  static struct record records[SIZE_BATCH];
+  struct record_reader *fastq;
+  struct counts *c = counts;
+  int i, t, n;
+
+  if ((fastq = open_records(name_fastq, n_threads)) == NULL)
   { ERROR_MESSAGE(207, name_fastq); }
 
-  while (fgets(line, MAX_CHAR, fastq) != NULL)  /* 1st line */
+  for (t = 0; t < n_threads && reporting; t++)
   {
-    if (fgets(line, MAX_CHAR, fastq) == NULL)   /* 2nd line */
-    { ERROR_MESSAGE(208, line); }
-    if (fgets(line, MAX_CHAR, fastq) == NULL)   /* 3rd line */
-    { ERROR_MESSAGE(209, line); }
-    if (fgets(line, MAX_CHAR, fastq) == NULL)   /* 4th line */
-    { ERROR_MESSAGE(210, line); }
-    l = strlen(line) - 1;       /* minus one for the new line */
-    count_allb += (unsigned long int)l;
-
-    for (i = 0; i < l; i++)
-    {
-      if (((short int)line[i] + CODE_TO_SCORE) >= (short int)minimum_qscore)
-      { count_base++; }
-    }
-    count_read++;
+    counts[t].lengths = (unsigned long int *)
+      calloc(MAX_CHAR, sizeof(unsigned long int));
+    counts[t].gc_reads = (unsigned long int *)
+      calloc(101, sizeof(unsigned long int));
+    counts[t].cycles = (unsigned long int *)
+      calloc(MAX_CHAR * N_QSCORES, sizeof(unsigned long int));
+    if (counts[t].lengths == NULL || counts[t].gc_reads == NULL ||
+        counts[t].cycles == NULL)
+    { ERROR_MESSAGE(226, "memory allocation for the report"); }
+  }
+
+  while ((n = next_records(fastq, records, SIZE_BATCH)) > 0)
+  {
+    if (count_batch(records, n)) { ERROR_MESSAGE(210, name_fastq); }
+  }
+  if (fastq->error > 0)	/* lines read of the last entry */
+  { ERROR_MESSAGE(207 + fastq->error, name_fastq); }
+  close_records(fastq);
+
+  for (t = 1; t < n_threads; t++)	/* sum up into counts[0] */
+  {
+    c->count_read += counts[t].count_read;
+    c->count_base += counts[t].count_base;
+    c->count_allb += counts[t].count_allb;
+    c->count_gc += counts[t].count_gc;
+    c->count_tcag += counts[t].count_tcag;
+    for (i = 0; i < MAX_CHAR && reporting; i++)
+    { c->lengths[i] += counts[t].lengths[i]; }
+    for (i = 0; i <= 100 && reporting; i++)
+    { c->gc_reads[i] += counts[t].gc_reads[i]; }
+    for (i = 0; i < MAX_CHAR * N_QSCORES && reporting; i++)
+    { c->cycles[i] += counts[t].cycles[i]; }
   }
 
-  fclose(fastq);
-  fprintf(stdout, "%lu\t%lu\t%lu\n", count_read, count_base, count_allb);
+  fprintf(stdout, "%lu\t%lu\t%lu\n",
+          c->count_read, c->count_base, c->count_allb);
+  if (reporting) print_report(c);
   return EXIT_SUCCESS;
 }
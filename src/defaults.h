@@ -24,6 +24,10 @@
 /*   Dec 20, 2014  Ver. 0.6; set exit status                                 */
 /*   May 17, 2015  Add MIN_LENGTH and ERROR_MESSAGE                          */
 /*   Aug 05, 2017  Ver. 0.7; support option -p                               */
+/*   Oct 17, 2026  Add DEFAULT_THREADS and MAX_THREADS                       */
+/*   Oct 17, 2026  Add DEFAULT_MISMATCHES                                    */
+/*   Oct 17, 2026  ERROR_MESSAGE calls fail_walk() instead of exit()         */
+/*   Oct 17, 2026  fail_walk() does not return                               */
 /*                                                                           */
 
 
@@ -54,12 +58,24 @@
 #define DEFAULT_MIN_OVERLAP    32
 	/* minimum overlapping length to be merged */
 
+#define DEFAULT_MISMATCHES     0
+	/* maximum number of mismatches in the overlap to be merged */
+
+#define DEFAULT_THREADS        1
+	/* number of threads to search reads for the seed */
+
+#define MAX_THREADS            64
+	/* maximum number of threads (option -j) */
+
 #define MAX_CHAR               0x400
 	/* this macro is used in many cases (0x400 = 1024) */
 
 #define MIN_LENGTH             8
 	/* reads whose lengths are shorter than this value are eliminated */
 
+_Noreturn void fail_walk(int, const char *, ...);
+	/* in libgrepwalk.c; exits unless called in a function of libgrepwalk */
+	/* or jumps back to it; resources should be freed or on the context */
+
 #define ERROR_MESSAGE(code, string) \
-  fprintf(stderr, "GrepWalk error %d: %s\n", (code), (string)); \
-  exit((code));
+  fail_walk((code), "GrepWalk error %d: %s", (code), (string));
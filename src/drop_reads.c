@@ -0,0 +1,279 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   drop_reads.c - drop reads the walk has passed from later passes         */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from read_reads.c, scan_reads.c, and              */
+/*   libgrepwalk.c when option -D is provided.                               */
+/*   A read holding the seed of a walker is held by the walker with the      */
+/*   position where the read ends in the assembled sequence.  At the end of  */
+/*   a pass, a held read is marked as passed by the walker when the seed     */
+/*   has moved so far that no window from the seed fits in the read.  A      */
+/*   read without window bases in a row whose quality scores are between     */
+/*   minimum_qscore and MAX_QSCORE, which check_read() always rejects, is    */
+/*   marked as passed by every walker when it is read first.                 */
+/*   A read passed by all the active walkers is dropped: it is neither       */
+/*   examined nor kept for the next pass.  The reads kept are listed by      */
+/*   their ordinal numbers for the read store (option -a), or rewritten      */
+/*   into a temporary file that the next pass reads instead of the input     */
+/*   file; with the k-mer index (option -k), dropped reads are skipped.      */
+/*   On a linear genome without repeats, a passed read cannot hold a later   */
+/*   seed, so that the sequences are the same as those without -D.  A read   */
+/*   is kept while another walker, e.g. the mate of option -B, has not       */
+/*   passed it.  Option -D is thus for linear walks: a walk going around a   */
+/*   circular genome stops near the initial seed, where the reads have been  */
+/*   dropped, instead of at the maximum length (-x), and its output is       */
+/*   shorter than without -D.  Use -C without -D for a circular genome.      */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Find bases out of the quality range with base_kernels.c   */
+/*   Oct 17, 2026  Keep the reads kept so far if they cannot be enlarged     */
+/*   Oct 17, 2026  Say that a circular genome stops near the seed with -D    */
+/*                                                                           */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "defaults.h"
+#include "grepwalk.h"
+#include "examine_reads.h"
+#include "record_reader.h"
+
+#define PASSED(k) (1 << ((2 * (k)) % 8))	/* walker k has passed it */
+#define HELD(k) (1 << ((2 * (k) + 1) % 8))	/* walker k holds it */
+
+
+int read_record(struct record_reader *, char *, char *);
+int fetch_stored_read(struct read_store *, long int, char *, char *);
+struct record_reader *reopen_records(FILE *);
+void close_records(struct record_reader *);
+long int tell_records(struct record_reader *);
+int find_outside(char *, int, int, int, int);
+
+
+void *grow_set(void *array, long int size_old, long int size_new)
+{	/* the added part is filled with zeros */
+  if ((array = realloc(array, (size_t)size_new)) == NULL)
+  { ERROR_MESSAGE(226, "memory allocation for the reads kept (-D)"); }
+  memset((char *)array + size_old, 0, (size_t)(size_new - size_old));
+  return array;
+}
+
+
+/*                                                                           */
+/* open_working_set()                                                        */
+/*                                                                           */
+/*   This function is called from read_reads() before the first pass.        */
+/*                                                                           */
+void open_working_set(struct grepwalk *gw)
+{
+  struct working_set *s = &gw->set;
+
+  s->stride = (2 * gw->n_walkers + 1 + 7) / 8;
+  if (gw->store == NULL && gw->index == NULL && (s->next = tmpfile()) == NULL)
+  { ERROR_MESSAGE(229, "temporary file for the reads kept (-D)"); }
+}
+
+
+void free_working_set(struct working_set *s)
+{
+  free(s->marks);
+  free(s->live);
+  free(s->kept);
+  if (s->next != NULL) fclose(s->next);
+  memset(s, 0, sizeof(*s));
+}
+
+
+/*                                                                           */
+/* has_window()                                                              */
+/*                                                                           */
+/*   This function returns 1 when a read has window bases in a row whose     */
+/*   quality scores pass the test of check_read(), on either strand.         */
+/*                                                                           */
+int has_window(struct grepwalk *gw, char *qscores)
+{
+  int i, bad, length = strlen(qscores);
+
+  for (i = 0; i + gw->window <= length; i = bad + 1)
+  {
+    bad = find_outside(qscores, i, length,
+                       gw->minimum_qscore - CODE_TO_SCORE,
+                       MAX_QSCORE - CODE_TO_SCORE);
+    if (bad - i >= gw->window) return 1;
+  }
+  return 0;
+}
+
+
+/*                                                                           */
+/* drop_read()                                                               */
+/*                                                                           */
+/*   This function marks a read when it is read first, and returns 1 when    */
+/*   the read is to be dropped, i.e. passed by all the active walkers.       */
+/*                                                                           */
+int drop_read(struct grepwalk *gw, long int id, char *qscores)
+{
+  struct working_set *s = &gw->set;
+  unsigned char *m;
+  long int size;
+  int k, seen = 2 * gw->n_walkers;
+
+  if (id >= s->size_marks)
+  {
+    for (size = s->size_marks > 0 ? s->size_marks : 0x10000; size <= id; )
+    { size *= 2; }
+    s->marks = grow_set(s->marks, s->size_marks * s->stride,
+                        size * s->stride);
+    s->size_marks = size;
+  }
+  if (id >= s->n_reads) s->n_reads = id + 1;
+  m = s->marks + id * s->stride;
+  if (!(m[seen / 8] & (1 << (seen % 8))))
+  {	/* read first */
+    m[seen / 8] |= 1 << (seen % 8);
+    if (!has_window(gw, qscores))
+    { for (k = 0; k < gw->n_walkers; k++) m[2 * k / 8] |= PASSED(k); }
+  }
+  for (k = 0; k < gw->n_walkers; k++)
+  {
+    if (gw->walkers[k].active && !(m[2 * k / 8] & PASSED(k))) return 0;
+  }
+  gw->stats.n_dropped++;
+  return 1;
+}
+
+
+/*                                                                           */
+/* hold_read()                                                               */
+/*                                                                           */
+/*   This function is called when the seed of a walker is found in a read,   */
+/*   before check_read() moves the seed.  Length is the number of bases      */
+/*   from the seed to the end of the read.  A read is held only once.        */
+/*                                                                           */
+void hold_read(struct walker *w, long int id, int length)
+{
+  struct grepwalk *gw = w->gw;
+  struct held_read *h;
+  unsigned char *m;
+  int k = (int)(w - gw->walkers);
+
+  if (!gw->dropping) return;
+  m = gw->set.marks + id * gw->set.stride + 2 * k / 8;
+  if (*m & (PASSED(k) | HELD(k))) return;
+  *m |= HELD(k);
+  if (w->n_held == w->size_held)
+  {
+    h = (struct held_read *)realloc(w->held, (w->size_held + SIZE_ARRAY) *
+                                             sizeof(struct held_read));
+    if (h == NULL) { ERROR_MESSAGE(226, "memory allocation for reads held"); }
+    w->held = h;
+    w->size_held += SIZE_ARRAY;
+  }
+  h = w->held + w->n_held++;
+  h->id = id;
+  h->end = w->length_assembled - w->matcher.k + length;
+}
+
+
+/*                                                                           */
+/* next_live_read()                                                          */
+/*                                                                           */
+/*   This function is called from next_read() instead of reading the file    */
+/*   or the store in order.  It gets the next read of the current pass       */
+/*   that is not dropped, and keeps it for the next pass.  The ordinal       */
+/*   number of the read plus one is left in *id.  It returns 0 at the end    */
+/*   of the pass.                                                            */
+/*                                                                           */
+int next_live_read(struct grepwalk *gw, long int *id,
+                   char *sequence, char *qscores)
+{
+  struct working_set *s = &gw->set;
+  long int read, position, size, *kept;
+
+  for (;;)
+  {
+    if (s->live != NULL && s->taken >= s->n_live) return 0;
+    read = s->live != NULL ? s->live[s->taken] : s->taken;
+    if (gw->store != NULL)
+    {
+      if (!fetch_stored_read(gw->store, read, sequence, qscores)) return 0;
+      gw->stats.bytes_scanned += 2 * (long int)strlen(sequence);
+    }
+    else
+    {
+      position = tell_records(gw->fastq);
+      if (!read_record(gw->fastq, sequence, qscores)) return 0;
+      gw->stats.bytes_scanned += tell_records(gw->fastq) - position;
+    }
+    s->taken++;
+    gw->stats.n_scanned++;
+    if (!drop_read(gw, read, qscores)) break;
+  }
+
+  if (s->n_kept == s->size_kept)
+  {
+    size = s->size_kept > 0 ? 2 * s->size_kept : 0x10000;
+    if ((kept = (long int *)realloc(s->kept, size * sizeof(long int))) == NULL)
+    { ERROR_MESSAGE(226, "memory allocation for the reads kept (-D)"); }
+    s->kept = kept;
+    s->size_kept = size;
+  }
+  s->kept[s->n_kept++] = read;
+  if (s->next != NULL) fprintf(s->next, "@\n%s\n+\n%s\n", sequence, qscores);
+  *id = read + 1;
+  return 1;
+}
+
+
+/*                                                                           */
+/* pass_working_set()                                                        */
+/*                                                                           */
+/*   This function is called from read_reads() between passes.  Reads held   */
+/*   by each active walker are marked as passed if the walker has moved      */
+/*   beyond them, and the reads kept in the pass are read in the next one.   */
+/*                                                                           */
+void pass_working_set(struct grepwalk *gw)
+{
+  struct working_set *s = &gw->set;
+  struct walker *w;
+  struct held_read *h;
+  unsigned char *m;
+  long int *live, size;
+  int i, k, n;
+
+  for (k = 0; k < gw->n_walkers; k++)
+  {
+    w = gw->walkers + k;
+    if (!w->active) continue;
+    for (n = i = 0; i < w->n_held; i++)
+    {
+      h = w->held + i;
+      if (w->length_assembled - w->matcher.k + gw->window <= h->end)
+      { w->held[n++] = *h; continue; }
+      m = s->marks + h->id * s->stride + 2 * k / 8;
+      *m = (*m & ~HELD(k)) | PASSED(k);
+    }
+    w->n_held = n;
+  }
+  if (gw->index != NULL) return;	/* reads are looked up, not kept */
+
+  live = s->live; size = s->size_live;
+  s->live = s->kept; s->n_live = s->n_kept; s->size_live = s->size_kept;
+  s->kept = live; s->n_kept = 0; s->size_kept = size;
+  s->taken = 0;
+  if (gw->store == NULL)
+  {	/* the next pass reads the temporary file */
+    if (fflush(s->next) != 0 || ferror(s->next))
+    { ERROR_MESSAGE(229, "temporary file for the reads kept (-D)"); }
+    close_records(gw->fastq);
+    gw->fastq = reopen_records(s->next);
+    if ((s->next = tmpfile()) == NULL)
+    { ERROR_MESSAGE(229, "temporary file for the reads kept (-D)"); }
+  }
+}
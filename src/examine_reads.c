@@ -18,171 +18,395 @@
 /*   Sep 27, 2014  Add lastly_struggle()                                     */
 /*   Dec 02, 2014  Add print_nominee_table(); set exit status                */
 /*   Mar 23, 2015  Support option -r to ignore directions of reads           */
+/*   Oct 17, 2026  Each function takes a walker instead of global variables  */
+/*   Oct 17, 2026  Rebuild the seed matcher when the seed is extended        */
+/*   Oct 17, 2026  Hash the nominee table; grow it instead of exit(2)        */
+/*   Oct 17, 2026  lastly_struggle() visits a prefix trie of the nominees    */
+/*   Oct 17, 2026  Count hits and write a row for each extension (-T)        */
+/*   Oct 17, 2026  Take the parameters from the context of the walker        */
+/*   Oct 17, 2026  Look up the quality window in runs of good bases          */
+/*   Oct 17, 2026  Find bases out of the quality range with base_kernels.c   */
+/*   Oct 17, 2026  Free the memory of lastly_struggle() before an error      */
 /*                                                                           */
 
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "defaults.h"
+#include "grepwalk.h"
 #include "examine_reads.h"
 
 
-extern short int nondirec;
+int print_bases(struct walker *, char *);
+void build_seed_matcher(struct walker *);
+void print_step(struct walker *, int, int, int);
+int find_outside(char *, int, int, int, int);
 
 
-/**** the nominee table ****/
-struct list
-{
-  char extending_sequence[MAX_LEN_SEQ];
-  short int depth_strand1;
-  short int depth_strand2;
-};
-
-
-struct list table[SIZE_ARRAY];
-
-
-int print_bases(char *);
-
-
-void init_extending_seq_table(void)
+/*                                                                           */
+/* init_extending_seq_table()                                                */
+/*                                                                           */
+/*   This function empties the nominee table of a walker.  The table is      */
+/*   allocated at the first call; later it is emptied in constant time by    */
+/*   incrementing the generation, so that old slots are regarded as empty.   */
+/*                                                                           */
+void init_extending_seq_table(struct walker *w)
 {
-  int i;
-  for (i = 0; i < SIZE_ARRAY; i++)
+  if (w->table == NULL)
   {
-    table[i].extending_sequence[0] = '\0';
-    table[i].depth_strand1 = 0;
-    table[i].depth_strand2 = 0;
+    w->size_table = SIZE_ARRAY;
+    w->table = (struct list *)malloc(w->size_table * sizeof(struct list));
+    w->slots = (struct slot *)calloc(2 * w->size_table, sizeof(struct slot));
+    if (w->table == NULL || w->slots == NULL)
+    { ERROR_MESSAGE(226, "memory allocation for the nominee table"); }
+    w->generation = 0;
+  }
+  if (++w->generation == 0)
+  {	/* wrapped around; slots of old generations must be cleared */
+    memset(w->slots, 0, 2 * w->size_table * sizeof(struct slot));
+    w->generation = 1;
   }
+  w->n_table = 0;
 }
 
 
-int find_extending_seq(char *extending_seq)
-{	/* if exists, it returns 0 or more */
-  int i;
+/*                                                                           */
+/* find_extending_seq()                                                      */
+/*                                                                           */
+/*   This function encodes an extending sequence with two bits per base,     */
+/*   followed by a bit of 1 to tell the length, and looks up the slot by     */
+/*   linear probing.  It returns the slot holding the sequence, or the       */
+/*   empty slot where the sequence should be added, with the key set.        */
+/*                                                                           */
+struct slot *find_extending_seq(struct walker *w, char *extending_seq)
+{
+  uint64_t key[KEY_WORDS], h;
+  short int plain = 0;
+  int i, b;
+  unsigned long int mask = 2 * (unsigned long int)w->size_table - 1;
+  struct slot *slot;
+
+  memset(key, 0, sizeof(key));
+  for (i = 0; extending_seq[i] != '\0'; i++)
+  {
+    switch (extending_seq[i])
+    {
+      case 'A': b = 0; break;
+      case 'C': b = 1; break;
+      case 'G': b = 2; break;
+      case 'T': b = 3; break;
+      default:  b = 0; plain = 1;	/* compared as a string */
+    }
+    key[i / 32] |= (uint64_t)b << (2 * (i % 32));
+  }
+  key[i / 32] |= (uint64_t)1 << (2 * (i % 32));
 
-  for (i = 0; i < SIZE_ARRAY; i++)
+  for (h = 0, i = 0; i < KEY_WORDS; i++)
+  { h = (h ^ key[i]) * (uint64_t)0x9E3779B97F4A7C15ULL; }
+  for (h >>= 32; ; h++)
   {
-    if (table[i].extending_sequence[0] == '\0') return -1;
-    if (!strcmp(extending_seq, table[i].extending_sequence)) return i;
+    slot = w->slots + (h & mask);
+    if (slot->generation != w->generation)
+    {	/* empty */
+      memcpy(slot->key, key, sizeof(key));
+      slot->plain = plain;
+      return slot;
+    }
+    if (!memcmp(slot->key, key, sizeof(key)) && slot->plain == plain &&
+        (!plain ||
+         !strcmp(extending_seq, w->table[slot->n].extending_sequence)))
+    { return slot; }
   }
-  return -1;
 }
 
 
-void add_extending_seq(char *extending_seq)
+/*                                                                           */
+/* add_extending_seq()                                                       */
+/*                                                                           */
+/*   This function adds an extending sequence into the empty slot given by   */
+/*   find_extending_seq() and at the end of the nominee table.  When the     */
+/*   table is full, it is doubled and the slots are made again.              */
+/*   It returns the ordinal number for the table.                            */
+/*                                                                           */
+int add_extending_seq(struct walker *w, struct slot *slot, char *extending_seq)
 {
+  struct list *entry;
   int i;
 
-  for (i = 0; i < SIZE_ARRAY; i++)
+  if (w->n_table == w->size_table)
   {
-    if (table[i].extending_sequence[0] == '\0')
+    entry = (struct list *)realloc(w->table,
+                                   2 * w->size_table * sizeof(struct list));
+    if (entry == NULL)
+    { ERROR_MESSAGE(226, "memory allocation for the nominee table"); }
+    w->table = entry;
+    w->size_table *= 2;
+    free(w->slots);
+    w->slots = (struct slot *)calloc(2 * w->size_table, sizeof(struct slot));
+    if (w->slots == NULL)
+    { ERROR_MESSAGE(226, "memory allocation for the nominee table"); }
+    for (i = 0; i < w->n_table; i++)
     {
-      strcpy(table[i].extending_sequence, extending_seq);
-      if      (strand == 1) { table[i].depth_strand1 = 1; }
-      else if (strand == 2) { table[i].depth_strand2 = 1; }
-      else
-      {
-        fprintf(stderr, "Unexpected error 2: %d\n", (int)strand);
-        exit(EXIT_FAILURE);
-      }
-      return;
+      slot = find_extending_seq(w, w->table[i].extending_sequence);
+      slot->generation = w->generation;
+      slot->n = i;
     }
-    else { continue; }
+    slot = find_extending_seq(w, extending_seq);
   }
-  ns[2] = '\0'; print_bases(ns);	/* exceeded SIZE_ARRAY */
-  exit(2);	/* length of seed may be too short */
+
+  entry = w->table + w->n_table;
+  strcpy(entry->extending_sequence, extending_seq);
+  entry->depth_strand1 = entry->depth_strand2 = 0;
+  if      (w->strand == 1) { entry->depth_strand1 = 1; }
+  else if (w->strand == 2) { entry->depth_strand2 = 1; }
+  else
+  {
+    fail_walk(EXIT_FAILURE, "Unexpected error 2: %d", (int)w->strand);
+  }
+  slot->generation = w->generation;
+  slot->n = w->n_table;
+  return w->n_table++;
 }
 
 
-int lastly_struggle(void)
-{	/* This function struggles to extend the sequence as long as it can  */
-	/* at the last stage of GrepWalk. It returns extended length in bp.  */
-  int i, j, length_seed, length_extending;
+/**** an entry of the nominee table sorted by the extending sequence ****/
+struct sorted_entry
+{
+  char *extending_sequence;
+  int n;	/* the ordinal number for the table */
+  int lcp;	/* length of the common prefix with the previous one */
+};
 
-  length_seed = strlen(seed);
-  length_extending = window - length_seed - 1;
-  for (; length_extending > 0; length_extending--)
+/**** a node of the prefix trie, i.e., a run of the sorted entries ****/
+struct trie_node
+{
+  int length;	/* length of the common prefix */
+  int depth_strand1;
+  int depth_strand2;
+  int n;	/* the first inserted entry below this node */
+};
+
+
+int compare_sorted_entries(const void *a, const void *b)
+{
+  const struct sorted_entry *p = (const struct sorted_entry *)a;
+  const struct sorted_entry *q = (const struct sorted_entry *)b;
+  int c = strcmp(p->extending_sequence, q->extending_sequence);
+
+  return c != 0 ? c : p->n - q->n;
+}
+
+
+void merge_trie_node(struct trie_node *to, struct trie_node *from)
+{
+  to->depth_strand1 += from->depth_strand1;
+  to->depth_strand2 += from->depth_strand2;
+  if (from->n < to->n) to->n = from->n;
+}
+
+
+/*                                                                           */
+/* lastly_struggle()                                                         */
+/*                                                                           */
+/*   This function struggles to extend the sequence as long as it can when   */
+/*   no read extends it any longer.  Nominees sharing a prefix are summed    */
+/*   up, and the longest prefix shared by two or more of them whose depth    */
+/*   satisfies the rule of check_read() is taken.  Among prefixes of the     */
+/*   same length, the one of the first inserted nominee is taken.            */
+/*   The entries are sorted once, and every branching node of their prefix   */
+/*   trie is visited once on a stack over the common prefix lengths.  The    */
+/*   nominee table is not changed.                                           */
+/*   When the sequence is extended, the seed is moved as check_read() does,  */
+/*   so that the walk can go on (option -K) after the table is emptied.      */
+/*   It returns the extended length in bp.                                   */
+/*                                                                           */
+int lastly_struggle(struct walker *w)
+{
+  struct grepwalk *gw = w->gw;
+  struct list *table = w->table;
+  struct sorted_entry *sorted;
+  struct trie_node *stack, node, best;
+  int i, l, top, length_seed, length_seq;
+  char extending[MAX_CHAR];
+
+  if (w->n_table < 2) return 0;
+  sorted = (struct sorted_entry *)malloc(w->n_table *
+                                         sizeof(struct sorted_entry));
+  stack = (struct trie_node *)malloc((w->n_table + 1) *
+                                     sizeof(struct trie_node));
+  if (sorted == NULL || stack == NULL)
   {
-    for (i = 0; i < (SIZE_ARRAY - 1); i++)
+    free(sorted);
+    free(stack);
+    ERROR_MESSAGE(226, "memory allocation for the nominee table");
+  }
+
+  for (i = 0; i < w->n_table; i++)
+  {
+    sorted[i].extending_sequence = table[i].extending_sequence;
+    sorted[i].n = i;
+  }
+  qsort(sorted, w->n_table, sizeof(struct sorted_entry),
+        compare_sorted_entries);
+  for (i = 1; i < w->n_table; i++)
+  {
+    for (l = 0; sorted[i].extending_sequence[l] != '\0' &&
+                sorted[i].extending_sequence[l] ==
+                sorted[i - 1].extending_sequence[l]; l++) ;
+    sorted[i].lcp = l;
+  }
+
+  /**** visit the nodes bottom-up; each one is closed by a shorter lcp ****/
+  best.length = 0;
+  best.n = w->n_table;
+  top = 0;
+  stack[0].length = 0;
+  stack[0].depth_strand1 = stack[0].depth_strand2 = 0;
+  stack[0].n = w->n_table;
+  for (i = 1; i <= w->n_table; i++)
+  {
+    l = i < w->n_table ? sorted[i].lcp : 0;
+    node.length = -1;	/* the previous entry as a leaf */
+    node.depth_strand1 = table[sorted[i - 1].n].depth_strand1;
+    node.depth_strand2 = table[sorted[i - 1].n].depth_strand2;
+    node.n = sorted[i - 1].n;
+    while (stack[top].length > l)
+    {
+      merge_trie_node(&stack[top], &node);
+      node = stack[top--];
+      if (((node.depth_strand1 >= gw->strand_depth &&
+            node.depth_strand2 >= gw->strand_depth) ||
+           (gw->nondirec == 1 && node.depth_strand1 +
+                             node.depth_strand2 >= gw->strand_depth)) &&
+          (node.length > best.length ||
+           (node.length == best.length && node.n < best.n)))
+      { best = node; }
+    }
+    if (stack[top].length == l) { merge_trie_node(&stack[top], &node); }
+    else
     {
-      if (*table[i].extending_sequence == '\0') { break; }
-      table[i].extending_sequence[length_extending] = '\0';
-      if (*table[i].extending_sequence == '/') { continue; }
-      for (j = i + 1; j < SIZE_ARRAY; j++)
-      {
-        if (*table[j].extending_sequence == '\0') { break; } 
-        table[j].extending_sequence[length_extending] = '\0';
-        if (*table[j].extending_sequence == '/') { continue; } 
-        if (!strcmp(table[i].extending_sequence, table[j].extending_sequence))
-        {
-          table[i].depth_strand1 += table[j].depth_strand1;
-          table[i].depth_strand2 += table[j].depth_strand2;
-
-          if ((table[i].depth_strand1 >= strand_depth &&
-               table[i].depth_strand2 >= strand_depth) ||
-              (nondirec == 1 && table[i].depth_strand1 +
-                                table[i].depth_strand2 >= strand_depth))
-          {
-            print_bases(table[i].extending_sequence);
-            length_assembled += length_extending;
-            return table[i].depth_strand1 + table[i].depth_strand2;
-          }	/* successfully extended */
-
-          *table[j].extending_sequence = '/';	/* indicating empty */
-          table[j].depth_strand1 = table[j].depth_strand2 = 0;
-        }
-      }
+      stack[++top] = node;
+      stack[top].length = l;
     }
   }
-  return 0;	/* struggled, but cannot extend it */
+  free(sorted);
+  free(stack);
+  if (best.length == 0) return 0;	/* struggled, but cannot extend it */
+
+  /**** print the prefix and move the seed ****/
+  strncpy(extending, table[best.n].extending_sequence, best.length);
+  extending[best.length] = '\0';
+  print_bases(w, extending);
+  w->length_assembled += best.length;
+  print_step(w, best.length, best.depth_strand1, best.depth_strand2);
+
+  length_seed = strlen(w->seed);
+  strcat(w->seed, extending);
+  length_seq = length_seed + best.length;
+  if (length_seq > gw->window - gw->slide)
+  {
+    memmove(w->seed, w->seed + length_seq - (gw->window - gw->slide),
+            gw->window - gw->slide + 1);
+  }
+  build_seed_matcher(w);
+  return best.length;
+}
+
+
+/*                                                                           */
+/* quality_runs()                                                            */
+/*                                                                           */
+/*   This function turns the quality scores of a read into the number of     */
+/*   bases in a row ending at each base whose scores are between             */
+/*   minimum_qscore and MAX_QSCORE.  It is called once for a read holding    */
+/*   a seed, and the runs are shared by the walkers on both strands.         */
+/*                                                                           */
+void quality_runs(struct grepwalk *gw, char *qscores, struct quality_runs *q)
+{
+  int i, bad, length = strlen(qscores);
+  short int run;
+
+  for (i = 0; i < length; i++)
+  {	/* bad: the first base from i whose score is out of the range */
+    bad = find_outside(qscores, i, length,
+                       gw->minimum_qscore - CODE_TO_SCORE,
+                       MAX_QSCORE - CODE_TO_SCORE);
+    for (run = 0; i < bad; i++) q->run[i] = ++run;
+    if (i < length) q->run[i] = 0;
+  }
+  q->length = length;
 }
 
 
-int check_read(char *sequence, char *qscores)
+/*                                                                           */
+/* window_passes()                                                           */
+/*                                                                           */
+/*   This function tells whether window bases from offset of a strand have   */
+/*   good quality scores, in constant time.  On the minus strand, the        */
+/*   offset is counted from the end of the quality scores.                   */
+/*                                                                           */
+int window_passes(struct grepwalk *gw, struct quality_runs *q,
+                  int offset, short int strand)
 {
-  short int i, qscore;
+  if (offset + gw->window > q->length) return 0;
+  if (strand == 2) return q->run[q->length - 1 - offset] >= gw->window;
+  return q->run[offset + gw->window - 1] >= gw->window;
+}
+
+
+/*                                                                           */
+/* check_read()                                                              */
+/*                                                                           */
+/*   This function adds the bases following the seed of a read to the        */
+/*   nominee table, and extends the sequence when the depths are enough.     */
+/*   Passing tells whether the window from the seed has good quality         */
+/*   scores (see window_passes()); if not, the read is only counted.         */
+/*                                                                           */
+int check_read(struct walker *w, char *sequence, int passing)
+{
+  struct grepwalk *gw = w->gw;
+  struct list *table = w->table;
   int n;	/* the ordinal number for the table */
   int length_seed, length_extended;
   char *extending;
+  struct slot *slot;
 
   /**** eliminate a short or low-quality sequence ****/
 
-  if ((int)strlen(qscores) < window) { return 0; }
-  for (i = 0; i < window; i++)
-  {
-    qscore = (short int)qscores[i] + CODE_TO_SCORE;
-    if (minimum_qscore <= qscore && qscore <= MAX_QSCORE) { continue; }
-    else { return 0; }
-  }
-  sequence[i] = '\0';
-  length_seed = strlen(seed);
-  length_extended = window - length_seed;
+  if (w->strand == 1) w->hits_plus++; else w->hits_minus++;
+  if (!passing) { w->rejected++; return 0; }
+  sequence[gw->window] = '\0';
+  length_seed = strlen(w->seed);
+  length_extended = gw->window - length_seed;
   extending = sequence + length_seed;
 
-  n = find_extending_seq(extending);
-  if (n < 0)
-  { add_extending_seq(extending); }
+  slot = find_extending_seq(w, extending);
+  if (slot->generation != w->generation)
+  { n = add_extending_seq(w, slot, extending); table = w->table; }
   else
   {
-    if      (strand == 1) { table[n].depth_strand1++; }
-    else if (strand == 2) { table[n].depth_strand2++; }
+    n = slot->n;
+    if      (w->strand == 1) { table[n].depth_strand1++; }
+    else if (w->strand == 2) { table[n].depth_strand2++; }
     else
     {
-      fprintf(stderr, "Unexpected error 1: %d\n", (int)strand);
-      exit(EXIT_FAILURE);
+      fail_walk(EXIT_FAILURE, "Unexpected error 1: %d", (int)w->strand);
     }
-    if ((table[n].depth_strand1 >= strand_depth &&
-         table[n].depth_strand2 >= strand_depth) ||
-        (nondirec == 1 && table[n].depth_strand1 +
-                          table[n].depth_strand2 >= strand_depth))
+    if ((table[n].depth_strand1 >= gw->strand_depth &&
+         table[n].depth_strand2 >= gw->strand_depth) ||
+        (gw->nondirec == 1 && table[n].depth_strand1 +
+                          table[n].depth_strand2 >= gw->strand_depth))
     {
-      print_bases(extending);
-      length_assembled += length_extended;
-      strcpy(seed, extending + slide - length_seed);
-      strand = 0;
-      loop_counter++;
-      init_extending_seq_table();
+      print_bases(w, extending);
+      w->length_assembled += length_extended;
+      print_step(w, length_extended,
+                 table[n].depth_strand1, table[n].depth_strand2);
+      strcpy(w->seed, extending + gw->slide - length_seed);
+      build_seed_matcher(w);
+      w->strand = 0;
+      w->loop_counter++;
+      init_extending_seq_table(w);
     }
   }
 
@@ -190,22 +414,18 @@ int check_read(char *sequence, char *qscores)
 }
 
 
-int print_nominee_table(void)
+int print_nominee_table(struct walker *w)
 {
+  struct list *table = w->table;
   int i = 0;
 
-  for (; i < SIZE_ARRAY; i++)
+  for (; i < w->n_table; i++)
   {
-    if (table[i].extending_sequence[0] != '\0' &&
-        table[i].extending_sequence[0] != '/')
-    {
-      fprintf(stderr, "%s\t%d\t%d\t%d\n",
-              table[i].extending_sequence,
-              (int)table[i].depth_strand1,
-              (int)table[i].depth_strand2,
-              (int)(table[i].depth_strand1 + table[i].depth_strand2));
-    }
-    else { return i; }	/* number of printed rows */
+    fprintf(w->gw->nominees, "%s\t%d\t%d\t%d\n",
+            table[i].extending_sequence,
+            (int)table[i].depth_strand1,
+            (int)table[i].depth_strand2,
+            (int)(table[i].depth_strand1 + table[i].depth_strand2));
   }
-  return i;	/* SIZE_ARRAY */
+  return i;	/* number of printed rows */
 }
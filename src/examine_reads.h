@@ -17,23 +17,108 @@
 /*   Mar 04, 2014  Some comments were added                                  */
 /*   Apr 07, 2014  Conversion from string literal to 'char *' is deprecated  */
 /*   Oct 11, 2014  Change SIZE_ARRAY from 256 to 512                         */
+/*   Oct 17, 2026  Move the state of a walk into struct walker (option -S)   */
+/*   Oct 17, 2026  Add struct matcher for seed_matcher.c                     */
+/*   Oct 17, 2026  The nominee table grows and is looked up by hashing       */
+/*   Oct 17, 2026  Keep the bases of a walker paired with its mate (-B)      */
+/*   Oct 17, 2026  Count hits and rejected reads for walk_stats.c (-T)       */
+/*   Oct 17, 2026  A walker points to its context instead of global values   */
+/*   Oct 17, 2026  Hold reads hit until the walk has passed them (-D)        */
+/*   Oct 17, 2026  Add struct quality_runs for the window of check_read()    */
+/*   Oct 17, 2026  Encode the whole seed in words of 32 bases (matcher)      */
+/*   Oct 17, 2026  Hash the k-mers assembled to close a circle (option -C)   */
+/*   Oct 17, 2026  Keep the code with which a walker is finished (-F, -R)    */
+/*   Oct 17, 2026  Tell a walker finished for lack of depth (option -E)      */
 /*                                                                           */
 
 
+#include <stdint.h>
+
 #define CODE_TO_SCORE (short int)(-33)
 #define MAX_QSCORE 44
 #define SIZE_ARRAY 512
 #define MAX_LEN_SEQ 64
+#define KEY_WORDS ((MAX_LEN_SEQ + 31) / 32)
+#define SEED_WORDS ((MAX_CHAR + 31) / 32)
+
+/**** the nominee table, in the order of insertion ****/
+struct list
+{
+  char extending_sequence[MAX_LEN_SEQ];
+  short int depth_strand1;
+  short int depth_strand2;
+};
+
+/**** a slot of the hash table pointing to the nominee table ****/
+struct slot
+{
+  uint64_t key[KEY_WORDS];	/* two bits per base */
+  unsigned int generation;	/* empty unless equal to that of the walker */
+  short int plain;		/* 1 if other than T, C, A, or G is included */
+  int n;			/* the ordinal number for the nominee table */
+};
+
+/**** the seed encoded for seed_matcher.c ****/
+struct matcher
+{
+  int k;			/* length of the seed */
+  int n_words;			/* words of 32 bases; the last one may overlap */
+  uint64_t mask;
+  uint64_t plus[SEED_WORDS];	/* the seed, two bits per base */
+  uint64_t minus[SEED_WORDS];	/* its reverse complement */
+  char seed_minus[MAX_CHAR];	/* reverse complement of the seed */
+};
+
+/**** quality scores of a read turned into runs of good bases ****/
+struct quality_runs
+{
+  int length;			/* of the quality scores; -1 until turned */
+  short int run[MAX_CHAR];	/* good bases in a row ending at each base */
+};
+
+/**** a read holding the seed, not yet passed by the walker (option -D) ****/
+struct held_read
+{
+  long int id;			/* ordinal number of the read */
+  long int end;			/* where the read ends in the sequence */
+};
+
+/**** the state of a walk from one seed ****/
+struct walker
+{
+  struct grepwalk *gw;		/* the context of the walk */
+  char name[MAX_CHAR];		/* printed in the FASTA header */
+  char seed[MAX_CHAR];
+  struct matcher matcher;	/* rebuilt whenever the seed is changed */
+  long int length_assembled;
+  short int strand;		/* 1: plus strand; 2: minus strand */
+  short int loop_counter;	/* number of extensions in the current pass */
+  short int active;		/* 0 when the walk is over */
+  short int finished;		/* the code given to finish_walker(), or 0 */
+  short int starved;		/* 1 if no extension had the depth */
+  struct list *table;		/* size_table entries, n_table used */
+  int n_table;
+  int size_table;
+  struct slot *slots;		/* 2 * size_table slots */
+  unsigned int generation;	/* incremented to empty the table */
+  char seq_buffer[MAX_CHAR];	/* bases not printed yet */
+  FILE *output;			/* the standard output or a temporary file */
+  int mate;			/* the walker on the other strand, or -1 */
+  int length_seed;		/* length of the initial seed */
+  long int met;			/* where the end of the mate is, or -1 */
+  char *contig;			/* bases kept to be stitched (option -B) */
+  long int length_contig;
+  long int size_contig;
+  long int length_checked;	/* bases searched for the end of the mate */
+				/*   or for a circle (option -C) */
+  long int hits_plus;		/* reads holding the seed since the last */
+  long int hits_minus;		/*   extension, on each strand, and those  */
+  long int rejected;		/*   rejected by the quality window (-T)   */
+  struct held_read *held;	/* size_held entries, n_held used (-D) */
+  int n_held;
+  int size_held;
+  long int *kmers;		/* positions plus one; 0 if empty (-C) */
+  int bits_kmers;		/* 2 ** bits_kmers slots */
+  long int n_kmers;		/* k-mers from the first base put */
+};
 
-extern int window;
-extern int slide;
-extern int minimum_qscore;
-extern long int length_assembled;
-extern short int strand_depth;
-extern short int strand;
-extern short int loop_counter;
-extern char seed[];
-extern char ns[];
-	/* Note that "extern char *seed;" cannot be used here. */
-	/* They have different meanings.                       */
-	/* It could cause a segmentation fault.                */
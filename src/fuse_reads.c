@@ -0,0 +1,138 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   fuse_reads.c - trim and merge paired reads into the read store          */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from grepwalk.c when option -P is provided.       */
+/*   Pairs of entries are taken in batches from the two files, as in         */
+/*   merge_fastq(), and trimmed with trim_batch() and merged with            */
+/*   merge_batch() into outputs kept in memory.  The merged entries are      */
+/*   then packed into the read store, so that the walk runs on the same      */
+/*   reads as with -t, -g, and -a in turn, without intermediate files.       */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Pack the merged entries into the store of struct grepwalk */
+/*   Oct 17, 2026  The read store is given the window as well                */
+/*                                                                           */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "defaults.h"
+#include "grepwalk.h"
+#include "record_reader.h"
+#include "bgzf.h"
+
+#define SIZE_BATCH 0x1000
+
+
+struct record_reader *open_records(char *, int);
+int next_records(struct record_reader *, struct record *, int);
+void seek_records(struct record_reader *, long int);
+void close_records(struct record_reader *);
+int read_record(struct record_reader *, char *, char *);
+struct bgzf_output *open_output(FILE *, short int, int);
+void close_output(struct bgzf_output *);
+int trim_batch(struct bgzf_output *, struct record *, int);
+int merge_batch(struct bgzf_output *, struct record *, struct record *,
+                int, int);
+struct read_store *new_read_store(int, int);
+void store_read(struct read_store *, char *, char *);
+
+
+/*                                                                           */
+/* text_records()                                                            */
+/*                                                                           */
+/*   This function prepares a reader of the entries in a text, which works   */
+/*   as a file read to the end.  The reader need not be closed.              */
+/*                                                                           */
+void text_records(struct record_reader *r, struct text *t)
+{
+  memset(r, 0, sizeof(*r));
+  r->data = t->data;
+  r->size = t->size;
+  r->eof = 1;
+}
+
+
+/*                                                                           */
+/* fuse_reads()                                                              */
+/*                                                                           */
+/*   This function trims and merges paired FASTQ files, and packs the        */
+/*   merged entries into the read store of the walk.  It returns the number  */
+/*   of reads stored.  The exit status for an error is the same as that of   */
+/*   -t or -g.                                                               */
+/*                                                                           */
+long int fuse_reads(struct grepwalk *gw, char *name_fastq_r1,
+                    char *name_fastq_r2, int min_overlap)
+{
+  static struct record records1[SIZE_BATCH], records2[SIZE_BATCH];
+  static struct record trimmed1[SIZE_BATCH], trimmed2[SIZE_BATCH];
+  char headers[2 * MAX_CHAR];	/* for an error message */
+  char sequence[MAX_CHAR];
+  char qscores[MAX_CHAR];
+  long int n_reads = 0;
+  int i, n1, n2, n_threads = gw->n_threads;
+  struct record_reader *fastq1, *fastq2, text;
+  struct bgzf_output *output1, *output2, *merged;
+
+  if ((fastq1 = open_records(name_fastq_r1, n_threads)) == NULL)
+  { ERROR_MESSAGE(218, name_fastq_r1); }
+  if ((fastq2 = open_records(name_fastq_r2, n_threads)) == NULL)
+  { ERROR_MESSAGE(219, name_fastq_r2); }
+  output1 = open_output(NULL, 0, n_threads);
+  output2 = open_output(NULL, 0, n_threads);
+  merged = open_output(NULL, 0, n_threads);
+  if (gw->store == NULL)
+  { gw->store = new_read_store(gw->minimum_qscore, gw->window); }
+
+  while ((n1 = next_records(fastq1, records1, SIZE_BATCH)) > 0)
+  {
+    if ((n2 = next_records(fastq2, records2, n1)) == 0)
+    {
+      if (fastq2->error > 0) { ERROR_MESSAGE(221, name_fastq_r2); }
+      fprintf(stderr, "Unexpected file end: %s\n", name_fastq_r2);
+      exit(220);
+    }
+    if (n2 < n1) seek_records(fastq1, records1[n2].offset);
+
+    /**** trim both; the trimmed entries are found again in the texts ****/
+    output1->text.size = output2->text.size = merged->text.size = 0;
+    if (trim_batch(output1, records1, n2))
+    { ERROR_MESSAGE(215, name_fastq_r1); }
+    if (trim_batch(output2, records2, n2))
+    { ERROR_MESSAGE(215, name_fastq_r2); }
+    text_records(&text, &output1->text);
+    next_records(&text, trimmed1, n2);
+    text_records(&text, &output2->text);
+    next_records(&text, trimmed2, n2);
+
+    /**** merge them, and store the merged entries in order ****/
+    if ((i = merge_batch(merged, trimmed1, trimmed2, n2, min_overlap)) >= 0)
+    {
+      sprintf(headers, "%.*s\n%.*s\n",
+              trimmed1[i].length_header < MAX_CHAR ?
+              trimmed1[i].length_header : 0, trimmed1[i].header,
+              trimmed2[i].length_header < MAX_CHAR ?
+              trimmed2[i].length_header : 0, trimmed2[i].header);
+      ERROR_MESSAGE(221, headers);
+    }
+    text_records(&text, &merged->text);
+    while (read_record(&text, sequence, qscores))
+    {
+      store_read(gw->store, sequence, qscores);
+      n_reads++;
+    }
+  }
+  if (fastq1->error > 0) { ERROR_MESSAGE(221, name_fastq_r1); }
+
+  close_output(output1); close_output(output2); close_output(merged);
+  close_records(fastq1); close_records(fastq2);
+  return n_reads;
+}
@@ -10,7 +10,9 @@
 /* DESCRIPTION                                                               */
 /*   This file contains the main module of the GrepWalk programme.           */
 /*   This module performs initial setup and calls count_reads_bases(),       */
-/*   trim_low_quality_bases(), merge_fastq(), or read_reads().               */
+/*   trim_low_quality_bases(), merge_fastq(), or walk_reads().               */
+/*   A walk is run by the functions of libgrepwalk.c on struct grepwalk,     */
+/*   which is filled here from the options.                                  */
 /*                                                                           */
 /* AUTHOR                                                                    */
 /*   Coded by Kohji OKAMURA, Ph.D.                                           */
@@ -36,42 +38,112 @@
 /*   Mar 22, 2015  Support option -r to ignore directions of reads           */
 /*   May 27, 2015  Beta version commented out                                */
 /*   Aug 05, 2017  Support optino -p to slim FASTQ files                     */
+/*   Oct 17, 2026  Support option -k to walk with a k-mer index              */
+/*   Oct 17, 2026  Support option -a to keep reads in memory                 */
+/*   Oct 17, 2026  Support option -j to search reads in threads              */
+/*   Oct 17, 2026  Support option -S to walk from seeds in a file            */
+/*   Oct 17, 2026  Support option -K to keep walking after a struggle        */
+/*   Oct 17, 2026  Support option -z to compress the output into BGZF        */
+/*   Oct 17, 2026  Support option -Q to report qualities with option -u      */
+/*   Oct 17, 2026  Support option -M to merge overlaps with mismatches       */
+/*   Oct 17, 2026  Support option -P to trim, merge, and walk in one run     */
+/*   Oct 17, 2026  Support option -B to walk both ways at once               */
+/*   Oct 17, 2026  Support option -T to write a row for each extension       */
+/*   Oct 17, 2026  Walk with libgrepwalk.c; options fill struct grepwalk     */
+/*   Oct 17, 2026  Support option -D to drop reads the walk has passed       */
+/*   Oct 17, 2026  Support option -C to stop a walk around a circle          */
+/*   Oct 17, 2026  Support options -F and -R to checkpoint and resume a walk */
+/*   Oct 17, 2026  Support option -E to extend a walk on reads appended      */
+/*   Oct 17, 2026  Reject option -P with -k, or without -g                   */
 /*                                                                           */
 
 
 #include <time.h>
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include "defaults.h"
+#include "grepwalk.h"
 
 extern char *optarg;
 
-int window;
-int slide;
 int minimum_qscore;
-int length_initial_seed;
-int n_columns;
-long int maximum_length;
+int n_threads;
+int maximum_mismatches;	/* in the overlap of paired reads (-g) */
 char initial_seed[MAX_CHAR];
-char seed[MAX_CHAR];
 char name[MAX_CHAR];
-short int strand_depth;	/* minimal depth for one of the two strands */
-short int complement = 0;	/* flag for complementary (default: no) */
-short int nominee = 0;	/* print the nominee table onto the stderr */
 short int id = 0;	/* print only IDs whose paired reads were merged */
-short int nondirec = 0;	/* Ignore direction of reads to count read depth */
 short int reduce_fastq = 0;	/* Remove needless characters in FASTQ */
+short int indexing = 0;	/* look up reads in a k-mer index file */
+short int storing = 0;	/* keep all reads in memory during the walk */
+short int compress_output = 0;	/* write BGZF with option -t or -g */
+short int reporting = 0;	/* report qualities, lengths, and G+C (-u) */
+short int fusing = 0;	/* trim and merge -f and -g in memory to walk */
 
-void uc_only_tcag(char *);
-int complementary_sequence(char *);
 int merge_fastq(char *, char *, int);
 int trim_low_quality_bases(char *);
-int read_reads(char *);
 int getopt(int, char * const [], const char *);
 int count_reads_bases(char *);
 int print_usage(void);
+long int fuse_reads(struct grepwalk *, char *, char *, int);
+void init_grepwalk(struct grepwalk *);
+int check_grepwalk(struct grepwalk *);
+int add_seed(struct grepwalk *, char *, char *);
+int load_reads(struct grepwalk *, char *);
+int index_reads(struct grepwalk *, char *, char *);
+int write_walk_stats(struct grepwalk *, char *);
+int walk_reads(struct grepwalk *, char *);
+void free_grepwalk(struct grepwalk *);
+
+
+/*                                                                           */
+/* report_walk()                                                             */
+/*                                                                           */
+/*   This function prints the message of an error returned by a function     */
+/*   of libgrepwalk.c, if any, and returns code as the exit status.          */
+/*                                                                           */
+int report_walk(struct grepwalk *gw, int code)
+{
+  if (code != 0) { fprintf(stderr, "%s\n", gw->message); }
+  return code;
+}
+
+
+/*                                                                           */
+/* read_seed_file()                                                          */
+/*                                                                           */
+/*   This function reads seeds from a file given with option -S.             */
+/*   Each line has one seed.  A line beginning with '>' names the seed in    */
+/*   the next line; otherwise the name given with option -n is numbered.     */
+/*   It returns 0, or the exit status for an inappropriate seed.             */
+/*                                                                           */
+int read_seed_file(struct grepwalk *gw, char *name_seeds)
+{
+  int n = 0, code, l;
+  char line[MAX_CHAR];
+  char name_seed[MAX_CHAR] = "";
+  FILE *fp;
+
+  if ((fp = fopen(name_seeds, "r")) == NULL)
+  { ERROR_MESSAGE(228, name_seeds); }
+  while (fgets(line, MAX_CHAR, fp) != NULL)
+  {
+    for (l = strlen(line); l > 0 && isspace(line[l - 1]); l--)
+    { line[l - 1] = '\0'; }
+    if (line[0] == '>') { strcpy(name_seed, line + 1); continue; }
+    if (l == 0) continue;
+    if (name_seed[0] == '\0') sprintf(name_seed, "%.1000s %d", name, n + 1);
+    if ((code = add_seed(gw, name_seed, line)) != 0)
+    { fclose(fp); return report_walk(gw, code); }
+    name_seed[0] = '\0';
+    n++;
+  }
+  fclose(fp);
+  if (n == 0) { ERROR_MESSAGE(228, name_seeds); }
+  return 0;
+}
 
 
 int main(int argc, char *argv[])
@@ -82,70 +154,105 @@ int main(int argc, char *argv[])
   int minimum_overlap;
   char name_fastq[MAX_CHAR] = "";	/* file name of fastq or fasta */
   char name_fastq_merge[MAX_CHAR] = "";	/* file name of fastq to merge */
+  char name_index[MAX_CHAR] = "";	/* file name of the k-mer index */
+  char name_seeds[MAX_CHAR] = "";	/* file name of seeds */
+  char name_stats[MAX_CHAR] = "";	/* file name of the rows of -T */
   short int trimming = 0;
   short int counting = 0;
+  struct grepwalk gw;			/* parameters of a walk */
   /* short int beta = 0; */
 
   /**** set defaults ****/
 
+  init_grepwalk(&gw);
   strcpy(initial_seed, DEFAULT_SEED);
-  window = DEFAULT_WINDOW;
-  slide = DEFAULT_SLIDE;
-  strand_depth = DEFAULT_STRAND_DEPTH;
   minimum_qscore = DEFAULT_MIN_QSCORE;
-  maximum_length = DEFAULT_MAX_LENGTH;
   minimum_overlap = DEFAULT_MIN_OVERLAP;
-  n_columns = DEFAULT_N_COLUMNS;
+  maximum_mismatches = DEFAULT_MISMATCHES;
+  n_threads = DEFAULT_THREADS;
   sprintf(name, "GrepWalk %s (%lu)", DEFAULT_VERSION, (long unsigned int)now);
 
   /**** process options ****/
 
-  while ((opt = getopt(argc, argv, "bcd:ef:g:hil:m:n:o:pq:rs:tuvw:x:")) != -1)
+  while ((opt = getopt(argc, argv, "aBbCcDd:eEf:F:g:hij:k:Kl:m:M:n:o:pPq:QrRs:S:tT:uvw:x:z")) != -1)
   {
     switch (opt)
     {
+      case 'a': storing = 1;
+                break;
+      case 'B': gw.bidirectional = 1;
+                break;
       case 'b': /* beta = 1; */
                 break;
-      case 'c': complement = 1;
+      case 'C': gw.circular = 1;
+                break;
+      case 'c': gw.complement = 1;
+                break;
+      case 'D': gw.dropping = 1;
+                break;
+      case 'd': gw.strand_depth = atoi(optarg);
                 break;
-      case 'd': strand_depth = atoi(optarg);
+      case 'e': gw.nominee = 1;
                 break;
-      case 'e': nominee = 1;
+      case 'E': gw.extending = 1;
                 break;
       case 'f': strcpy(name_fastq, optarg);
                 break;
+      case 'F': strcpy(gw.checkpoint, optarg);
+                break;
       case 'g': strcpy(name_fastq_merge, optarg);
                 break;
       case 'h': ;
                 return print_usage();
       case 'i': id = 1;
                 break;
-      case 'l': slide = atoi(optarg);
+      case 'j': n_threads = atoi(optarg);
+                break;
+      case 'k': strcpy(name_index, optarg);
+                indexing = 1;
+                break;
+      case 'K': gw.keep_walking = 1;
+                break;
+      case 'l': gw.slide = atoi(optarg);
                 break;
       case 'm': minimum_overlap = atoi(optarg);
                 break;
+      case 'M': maximum_mismatches = atoi(optarg);
+                break;
       case 'n': strcpy(name, optarg);
                 break;
-      case 'o': n_columns = atoi(optarg);
+      case 'o': gw.n_columns = atoi(optarg);
                 break;
       case 'p': reduce_fastq = 1;
                 break;
+      case 'P': fusing = 1;
+                break;
       case 'q': minimum_qscore = atoi(optarg);
                 break;
-      case 'r': nondirec = 1;
+      case 'Q': reporting = 1;
+                break;
+      case 'r': gw.nondirec = 1;
+                break;
+      case 'R': gw.resuming = 1;
                 break;
       case 's': strcpy(initial_seed, optarg);
                 break;
+      case 'S': strcpy(name_seeds, optarg);
+                break;
       case 't': trimming = 1;
                 break;
+      case 'T': strcpy(name_stats, optarg);
+                break;
       case 'u': counting = 1;
                 break;
       case 'v': fprintf(stdout, "GrepWalk %s (%s)\n",
                                 DEFAULT_VERSION, argv[0]);
                 return 201;
-      case 'w': window = atoi(optarg);
+      case 'w': gw.window = atoi(optarg);
+                break;
+      case 'x': gw.maximum_length = atol(optarg);
                 break;
-      case 'x': maximum_length = atol(optarg);
+      case 'z': compress_output = 1;
                 break;
       default:  fprintf(stderr, "Unknown option: %c\n", opt);
                 /* does not exit */
@@ -154,20 +261,18 @@ int main(int argc, char *argv[])
 
   /**** check sizes ****/
 
-  length_initial_seed = strlen(initial_seed);
-  if (length_initial_seed >= window)
-  {
-    fprintf(stderr,
-      "Seed length (%d) should be less than the window size (%d).\n",
-      length_initial_seed, window);
-    return 202;
+  gw.minimum_qscore = minimum_qscore;	/* also for trimming (-t, -P) */
+  gw.n_threads = n_threads;
+  if ((i = check_grepwalk(&gw)) != 0) return report_walk(&gw, i);
+  if (fusing && indexing)
+  {	/* the reads merged in memory have no file to be indexed */
+    fprintf(stderr, "Option -P cannot be used with option -k.\n");
+    return 232;
   }
-  if (slide >= window)
+  if (fusing && !strcmp(name_fastq_merge, ""))
   {
-    fprintf(stderr,
-      "Sliding size (%d) should be less than the window size (%d).\n",
-      slide, window);
-    return 203;
+    fprintf(stderr, "Option -P should be used with option -g.\n");
+    return 232;
   }
 
   /**** check programme name ****/
@@ -178,21 +283,17 @@ int main(int argc, char *argv[])
     return 204;
   }
 
-  /**** check the sequence of the initial seed ****/
-  uc_only_tcag(initial_seed);
-  for (i = 0; initial_seed[i] != '\0'; i++)
+  /**** check the sequence of the initial seed, or seeds in a file ****/
+
+  if (strcmp(name_seeds, ""))
   {
-    if (initial_seed[i] != 'T' && initial_seed[i] != 'C' &&
-        initial_seed[i] != 'A' && initial_seed[i] != 'G')
-    {
-      fprintf(stderr,
-        "Seed sequence (%s) should consists of only T, C, A, or G.\n",
-        initial_seed);
-      return 205;
-    }
+    if ((i = read_seed_file(&gw, name_seeds)) != 0) return i;
+  }
+  else
+  {
+    if ((i = add_seed(&gw, name, initial_seed)) != 0)
+    { return report_walk(&gw, i); }
   }
-  if (complement == 1) complementary_sequence(initial_seed);
-  strcpy(seed, initial_seed);
 
   /**** read reads, merge, trim, count, or print the current version ****/
 
@@ -207,9 +308,30 @@ int main(int argc, char *argv[])
 
   if (trimming) return trim_low_quality_bases(name_fastq);
 
+  if (strcmp(name_stats, "") && (fusing || !strcmp(name_fastq_merge, "")))
+  {	/* only for a walk */
+    if ((i = write_walk_stats(&gw, name_stats)) != 0)
+    { return report_walk(&gw, i); }
+  }
+
+  if (fusing && strcmp(name_fastq_merge, ""))
+  {	/* the walk runs on the reads kept in memory, not indexed */
+    fuse_reads(&gw, name_fastq, name_fastq_merge, minimum_overlap);
+    i = walk_reads(&gw, name_fastq);
+    free_grepwalk(&gw);
+    return report_walk(&gw, i);
+  }
+
   if (strcmp(name_fastq_merge, ""))	/* call merge_fastq() and exit */
     return merge_fastq(name_fastq, name_fastq_merge, minimum_overlap);
 
+  if (indexing && (i = index_reads(&gw, name_index, name_fastq)) != 0)
+  { return report_walk(&gw, i); }
+  if (storing && (i = load_reads(&gw, name_fastq)) != 0)
+  { return report_walk(&gw, i); }
+
   /* if (beta == 0) { return EXIT_FAILURE; } */
-  return read_reads(name_fastq);
+  i = walk_reads(&gw, name_fastq);
+  free_grepwalk(&gw);
+  return report_walk(&gw, i);
 }
@@ -0,0 +1,166 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   grepwalk.h - header file for libgrepwalk                                */
+/*                                                                           */
+/* SYNOPSIS                                                                  */
+/*   #include "defaults.h"                                                   */
+/*   #include "grepwalk.h"                                                   */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This is a header file for libgrepwalk.c, in which a walk is run on      */
+/*   struct grepwalk instead of process-global variables.  A program may     */
+/*   run walks from two or more contexts at the same time, e.g. in its own   */
+/*   threads, and the reads loaded or indexed by one context can be shared   */
+/*   by others with share_reads() instead of being read again.               */
+/*   Every function of libgrepwalk.c returns 0, or the exit status of the    */
+/*   grepwalk command for an error with the message left in gw->message.     */
+/*   The memory and the files left by an error are released by               */
+/*   free_grepwalk(), so that a program can go on after the error.           */
+/*   fail_walk() exits the process only when no function of libgrepwalk.c    */
+/*   is running in the thread, e.g. in the trimming and merging of           */
+/*   grepwalk.c.                                                             */
+/*                                                                           */
+/*     struct grepwalk gw;                                                   */
+/*                                                                           */
+/*     init_grepwalk(&gw);                                                   */
+/*     gw.n_threads = 4;                                                     */
+/*     if (add_seed(&gw, "mtDNA", DEFAULT_SEED) ||                           */
+/*         load_reads(&gw, "reads.fastq") ||                                 */
+/*         walk_reads(&gw, "reads.fastq"))                                   */
+/*     { fprintf(stderr, "%s\n", gw.message); }                              */
+/*     free_grepwalk(&gw);                                                   */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Add struct working_set for option -D                      */
+/*   Oct 17, 2026  Mark stored reads having a window of good quality         */
+/*   Oct 17, 2026  Add option -C to stop a walk around a circular genome     */
+/*   Oct 17, 2026  Add options -F and -R to checkpoint and resume a walk     */
+/*   Oct 17, 2026  Add option -E to extend a walk on reads appended          */
+/*   Oct 17, 2026  Add the fingerprint of the indexed file                   */
+/*   Oct 17, 2026  Keep what a function has open on the context for errors   */
+/*                                                                           */
+
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+/**** phases of a run timed with option -T ****/
+#define PHASE_PREPARE 0		/* trimming, merging, indexing, or loading */
+#define PHASE_SCAN 1		/* passes over the reads */
+#define PHASE_STRUGGLE 2	/* lastly_struggle() at the end of a pass */
+#define PHASE_OUTPUT 3		/* printing the sequences of the seeds */
+#define N_PHASES 4
+
+/**** reads kept in memory in a packed form (option -a) ****/
+struct read_store
+{
+  uint64_t n_reads;
+  uint64_t *offsets;		/* first base of each read; one more at the end */
+  unsigned char *bases;		/* four bases in a byte */
+  unsigned char *ns;		/* one bit for each base other than TCAG */
+  unsigned char *passes;	/* one bit for each base of good quality */
+  unsigned char *usable;	/* one bit for each read with a window */
+  uint64_t size_reads;		/* allocated for offsets */
+  uint64_t size_bases;		/* allocated for the bases */
+  int minimum_qscore;		/* with which the passes were set */
+  int window;			/* bases of good quality in a row to be usable */
+};
+
+/**** reads looked up by their k-mers (option -k) ****/
+struct kmer_index
+{
+  int k;			/* length of the indexed k-mers */
+  long int size_indexed;	/* size of the indexed file in bytes */
+  uint64_t fingerprint;		/* see fingerprint_file() */
+  uint64_t n_reads;
+  uint64_t n_keys;
+  uint64_t n_postings;
+  long int *offsets;		/* file position of each read */
+  uint64_t *keys;		/* canonical k-mers, sorted */
+  uint64_t *starts;		/* postings of keys[i] start here */
+  uint32_t *ids;		/* ordinal numbers of reads, ascending */
+  struct posting *postings;	/* NULL unless the index is being built */
+  struct kmer_index *appended;	/* the reads appended, until merged */
+};
+
+/**** rows and the summary of option -T ****/
+struct walk_stats
+{
+  FILE *fp;			/* NULL unless option -T is provided */
+  int n_passes;			/* passes over the reads */
+  long int n_scanned;		/* reads scanned in all the passes */
+  long int bytes_scanned;	/* bytes of the entries or stored reads */
+  long int n_steps;		/* rows written */
+  long int n_dropped;		/* reads skipped as dropped (option -D) */
+  int phase;
+  double seconds_phases[N_PHASES];
+  struct timeval time_start;	/* when the file is opened */
+  struct timeval time_phase;	/* when the current phase began */
+};
+
+/**** reads left in the passes (option -D) ****/
+struct working_set
+{
+  int stride;			/* bytes of marks for each read */
+  unsigned char *marks;		/* two bits per walker and one for each read */
+  long int n_reads;		/* reads marked so far */
+  long int size_marks;		/* reads for which marks are allocated */
+  long int *live;		/* reads of the current pass; NULL for all */
+  long int n_live;
+  long int size_live;
+  long int *kept;		/* reads kept for the next pass */
+  long int n_kept;
+  long int size_kept;
+  long int taken;		/* reads of the current pass taken so far */
+  FILE *next;			/* the reads kept, unless stored or indexed */
+};
+
+/**** the context of a walk ****/
+struct grepwalk
+{
+  /* parameters; init_grepwalk() sets the defaults */
+  int window;			/* option -w */
+  int slide;			/* option -l */
+  int minimum_qscore;		/* option -q */
+  short int strand_depth;	/* option -d */
+  long int maximum_length;	/* option -x */
+  int n_columns;		/* option -o */
+  int n_threads;		/* option -j */
+  short int complement;		/* option -c */
+  short int nominee;		/* option -e */
+  short int nondirec;		/* option -r */
+  short int keep_walking;	/* option -K */
+  short int bidirectional;	/* option -B */
+  short int dropping;		/* option -D */
+  short int circular;		/* option -C */
+  char checkpoint[MAX_CHAR];	/* option -F; empty unless provided */
+  short int resuming;		/* option -R */
+  short int extending;		/* option -E */
+  FILE *output;			/* the sequences; stdout by default */
+  FILE *nominees;		/* the nominee tables; stderr by default */
+
+  /* the state of the walk */
+  struct walker *walkers;	/* one walker for each seed */
+  int n_walkers;
+  struct read_store *store;	/* NULL unless the reads are kept */
+  struct kmer_index *index;	/* NULL unless the reads are indexed */
+  short int own_reads;		/* 0 if the reads are shared */
+  struct record_reader *fastq;	/* the file read in the passes, or loaded */
+  FILE *checkpoint_file;	/* NULL unless the checkpoint is loaded */
+  struct batch_read *batch;	/* for scan_reads.c */
+  struct hit *hits;
+  struct walk_stats stats;
+  struct working_set set;	/* used only with option -D */
+  long int first_read;		/* the next pass starts here (option -E) */
+
+  /* the error; see fail_walk() */
+  jmp_buf jump;
+  int code;
+  char message[MAX_CHAR];
+};
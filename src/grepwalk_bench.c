@@ -0,0 +1,474 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   grepwalk_bench.c - simulate reads and time each mode of GrepWalk        */
+/*                                                                           */
+/* SYNOPSIS                                                                  */
+/*   grepwalk_bench [-b num] [-c num] [-C num] [-d dir] [-e num] [-g num]    */
+/*                  [-j num] [-l num] [-r num] [-x file]                     */
+/*                                                                           */
+/* HOW TO COMPILE                                                            */
+/*   This programme is built and run by 'make bench'.                        */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   A circular genome like mtDNA, holding the default seed, and a linear    */
+/*   nuclear background are generated at random, and paired-end reads are    */
+/*   sampled from them at the coverages given.  The error rate of a base     */
+/*   rises from the 5' end to three times at the 3' end, and its quality     */
+/*   score follows the rate.  GrepWalk is then run for counting (-u),        */
+/*   trimming (-t), merging (-g), and walking on the merged reads, and one   */
+/*   tab-separated line is printed for each run: the time, reads and MB per  */
+/*   second of the input file, passes over the file, and the peak resident   */
+/*   set size of the process.  Passes of a walk are taken from the summary   */
+/*   of option -T, and NA is printed if they are not known.                  */
+/*                                                                           */
+/* OPTIONS                                                                   */
+/*   -b  Length of the nuclear background (default: 1000000)                 */
+/*   -c  Coverage of the circular genome (default: 100)                      */
+/*   -C  Coverage of the nuclear background (default: 1)                     */
+/*   -d  Directory where the reads are written (default: .)                  */
+/*   -e  Errors per 10000 bases at the 5' end (default: 20)                  */
+/*   -g  Length of the circular genome (default: 16500)                      */
+/*   -j  Number of threads given to GrepWalk (default: 1)                    */
+/*   -l  Read length (default: 150)                                          */
+/*   -r  Seed of the random numbers (default: 1)                             */
+/*   -x  GrepWalk to be run (default: ./grepwalk)                            */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Time a walk dropping passed reads (walk_D)                */
+/*   Oct 17, 2026  Time a walk stopping around the circle (walk_C)           */
+/*                                                                           */
+
+
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "defaults.h"
+
+#define MAX_ARGS 16
+#define MIN_BENCH_QSCORE 2
+#define MAX_BENCH_QSCORE 41
+
+
+int getopt(int, char * const [], const char *);
+
+
+/**** parameters of the simulation ****/
+long int length_genome = 16500;
+long int length_background = 1000000;
+double coverage_genome = 100.0;
+double coverage_background = 1.0;
+int length_read = 150;
+int error_rate = 20;		/* per 10000 bases at the 5' end */
+unsigned long int random_seed = 1;
+char threads[MAX_CHAR] = "1";
+char directory[MAX_CHAR] = ".";
+char grepwalk[MAX_CHAR] = "./grepwalk";
+
+uint64_t state;			/* of the random numbers */
+
+
+/**** the result of one run ****/
+struct run
+{
+  double seconds;
+  long int reads;		/* in the input file */
+  long int bytes;		/* of the input file */
+  int passes;			/* over the input file; 0 if not known */
+  long int peak_rss;		/* in kB */
+  int status;
+};
+
+
+/*                                                                           */
+/* next_random()                                                             */
+/*                                                                           */
+/*   This function returns a random number by xorshift64*, which is the      */
+/*   same on any C library for the same seed.                                */
+/*                                                                           */
+uint64_t next_random(void)
+{
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * UINT64_C(0x2545F4914F6CDD1D);
+}
+
+
+double uniform(void)
+{
+  return (double)(next_random() >> 11) / 9007199254740992.0;
+}
+
+
+char random_base(void)
+{
+  return "TCAG"[next_random() >> 62];
+}
+
+
+char complementary_base(char base)
+{
+  switch (base)
+  {
+    case 'T': return 'A';
+    case 'C': return 'G';
+    case 'A': return 'T';
+    case 'G': return 'C';
+    default:  return base;
+  }
+}
+
+
+/*                                                                           */
+/* make_genome()                                                             */
+/*                                                                           */
+/*   This function returns a random sequence of the length.  The default     */
+/*   seed is put at position 1000, or at the beginning of a short one.       */
+/*                                                                           */
+char *make_genome(long int length, short int seeded)
+{
+  char *genome;
+  long int i, l = (long int)strlen(DEFAULT_SEED);
+
+  if ((genome = (char *)malloc(length + 1)) == NULL)
+  {
+    fprintf(stderr, "grepwalk_bench: memory allocation\n");
+    exit(EXIT_FAILURE);
+  }
+  for (i = 0; i < length; i++) genome[i] = random_base();
+  genome[length] = '\0';
+  if (seeded && length >= l)
+  { memcpy(genome + (length >= 1000 + l ? 1000 : 0), DEFAULT_SEED, l); }
+  return genome;
+}
+
+
+/*                                                                           */
+/* print_read()                                                              */
+/*                                                                           */
+/*   This function prints an entry of a read with errors and quality scores  */
+/*   in the error profile.  A few bases are replaced with N.                 */
+/*                                                                           */
+void print_read(FILE *fp, long int n, int end, char *read)
+{
+  char qscores[MAX_CHAR];
+  double rate;
+  int i, q;
+
+  for (i = 0; i < length_read; i++)
+  {
+    rate = error_rate / 10000.0 *
+           (1.0 + 2.0 * i / (length_read > 1 ? length_read - 1 : 1));
+    q = (int)(-10.0 * log10(rate > 0.0 ? rate : 1e-5) + 0.5) +
+        (int)(next_random() % 5) - 2;
+    if (q < MIN_BENCH_QSCORE) q = MIN_BENCH_QSCORE;
+    if (q > MAX_BENCH_QSCORE) q = MAX_BENCH_QSCORE;
+    if (uniform() < rate)
+    {
+      do { q = random_base(); } while (q == read[i]);
+      read[i] = (char)q;
+      q = (int)(next_random() % 10) + MIN_BENCH_QSCORE;
+    }
+    if (uniform() < 0.0005) { read[i] = 'N'; q = MIN_BENCH_QSCORE; }
+    qscores[i] = (char)(q + 33);
+  }
+  read[length_read] = qscores[length_read] = '\0';
+  fprintf(fp, "@bench.%ld %d\n%s\n+\n%s\n", n, end, read, qscores);
+}
+
+
+/*                                                                           */
+/* simulate_reads()                                                          */
+/*                                                                           */
+/*   This function writes paired-end reads into bench_1.fastq and            */
+/*   bench_2.fastq in the directory.  Fragments are taken from the circular  */
+/*   genome or the background in proportion to the numbers of reads, on      */
+/*   either strand, and are no longer than twice the read length.            */
+/*   It returns the number of pairs.                                         */
+/*                                                                           */
+long int simulate_reads(void)
+{
+  char name[MAX_CHAR + 16];
+  char fragment[2 * MAX_CHAR], read[MAX_CHAR];
+  char *genome, *background;
+  long int n, n_genome, n_background, position;
+  int i, length;
+  short int circular;
+  FILE *fp1, *fp2;
+
+  genome = make_genome(length_genome, 1);
+  background = make_genome(length_background, 0);
+  n_genome = (long int)(length_genome * coverage_genome / (2 * length_read));
+  n_background = length_background < 2 * length_read ? 0 :
+    (long int)(length_background * coverage_background / (2 * length_read));
+
+  sprintf(name, "%s/bench_1.fastq", directory);
+  fp1 = fopen(name, "w");
+  sprintf(name, "%s/bench_2.fastq", directory);
+  fp2 = fopen(name, "w");
+  if (fp1 == NULL || fp2 == NULL)
+  { fprintf(stderr, "grepwalk_bench: %s\n", name); exit(EXIT_FAILURE); }
+
+  for (n = 0; n < n_genome + n_background; n++)
+  {
+    circular = uniform() * (n_genome + n_background) < n_genome;
+    length = length_read + length_read / 5 +
+             (int)(next_random() % (length_read * 4 / 5 - 15));
+    if (circular)
+    {
+      position = (long int)(next_random() % length_genome);
+      for (i = 0; i < length; i++)
+      { fragment[i] = genome[(position + i) % length_genome]; }
+    }
+    else
+    {
+      position = (long int)(next_random() %
+                            (length_background - length + 1));
+      memcpy(fragment, background + position, length);
+    }
+    if (next_random() >> 63)
+    {	/* the minus strand */
+      for (i = 0; i < length; i++)
+      { read[i] = complementary_base(fragment[length - 1 - i]); }
+      memcpy(fragment, read, length);
+    }
+    memcpy(read, fragment, length_read);
+    print_read(fp1, n, 1, read);
+    for (i = 0; i < length_read; i++)
+    { read[i] = complementary_base(fragment[length - 1 - i]); }
+    print_read(fp2, n, 2, read);
+  }
+  fclose(fp1);
+  fclose(fp2);
+  free(genome);
+  free(background);
+  return n;
+}
+
+
+/*                                                                           */
+/* count_entries()                                                           */
+/*                                                                           */
+/*   This function counts the entries of a FASTQ file and its bytes.         */
+/*                                                                           */
+long int count_entries(char *name, long int *bytes)
+{
+  FILE *fp;
+  long int lines = 0;
+  int c;
+
+  *bytes = 0;
+  if ((fp = fopen(name, "r")) == NULL) return 0;
+  while ((c = getc(fp)) != EOF)
+  {
+    (*bytes)++;
+    if (c == '\n') lines++;
+  }
+  fclose(fp);
+  return lines / 4;
+}
+
+
+/*                                                                           */
+/* run_grepwalk()                                                            */
+/*                                                                           */
+/*   This function runs GrepWalk with the arguments and the standard output  */
+/*   redirected to a file, and measures the time and the peak memory.        */
+/*                                                                           */
+void run_grepwalk(struct run *r, char *args[], char *input, char *output)
+{
+  struct timeval start, end;
+  struct rusage usage;
+  pid_t pid;
+  int fd, status;
+
+  r->reads = count_entries(input, &r->bytes);
+  gettimeofday(&start, NULL);
+  if ((pid = fork()) < 0)
+  { fprintf(stderr, "grepwalk_bench: fork\n"); exit(EXIT_FAILURE); }
+  if (pid == 0)
+  {
+    if ((fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    { _exit(127); }
+    dup2(fd, 1);
+    close(fd);
+    execv(args[0], args);
+    _exit(127);
+  }
+  wait4(pid, &status, 0, &usage);
+  gettimeofday(&end, NULL);
+
+  r->seconds = (end.tv_sec - start.tv_sec) +
+               (end.tv_usec - start.tv_usec) / 1e6;
+  r->peak_rss = (long int)usage.ru_maxrss;
+  r->status = WIFEXITED(status) ? WEXITSTATUS(status) : 128;
+}
+
+
+void print_result(char *mode, struct run *r)
+{
+  double seconds = r->seconds > 0.0 ? r->seconds : 1e-6;
+
+  fprintf(stdout, "%s\t%.3f\t%ld\t%ld\t%.0f\t%.2f\t", mode, r->seconds,
+          r->reads, r->bytes, r->reads / seconds, r->bytes / seconds / 1e6);
+  if (r->passes > 0) fprintf(stdout, "%d", r->passes);
+  else fprintf(stdout, "NA");
+  fprintf(stdout, "\t%ld\t%d\n", r->peak_rss, r->status);
+  fflush(stdout);
+}
+
+
+/*                                                                           */
+/* read_passes()                                                             */
+/*                                                                           */
+/*   This function returns the passes of a walk in the summary written with  */
+/*   option -T, or 0 if they are not found.                                  */
+/*                                                                           */
+int read_passes(char *name)
+{
+  char line[MAX_CHAR];
+  int passes = 0;
+  FILE *fp;
+
+  if ((fp = fopen(name, "r")) == NULL) return 0;
+  while (fgets(line, MAX_CHAR, fp) != NULL)
+  {
+    if (strncmp(line, "passes\t", 7) == 0) passes = atoi(line + 7);
+  }
+  fclose(fp);
+  return passes;
+}
+
+
+/*                                                                           */
+/* run_mode()                                                                */
+/*                                                                           */
+/*   This function runs GrepWalk in a mode with the options, which end with  */
+/*   NULL, and prints one line of the result.  Options -j and -f are added   */
+/*   here, and the files are in the directory.  Counting, trimming, and      */
+/*   merging read the input once; a walk is given option -T with the name    */
+/*   of stats, whose summary tells the passes.                               */
+/*                                                                           */
+void run_mode(char *mode, char *options[], char *input, char *output,
+              char *stats)
+{
+  char *args[MAX_ARGS];
+  char name_input[MAX_CHAR + 16], name_output[MAX_CHAR + 16];
+  char name_stats[MAX_CHAR + 16];
+  int i, n = 0;
+  struct run r;
+
+  sprintf(name_input, "%s/%s", directory, input);
+  sprintf(name_output, "%s/%s", directory, output);
+  args[n++] = grepwalk;
+  args[n++] = "-j";
+  args[n++] = threads;
+  if (stats != NULL)
+  {
+    sprintf(name_stats, "%s/%s", directory, stats);
+    args[n++] = "-T";
+    args[n++] = name_stats;
+  }
+  for (i = 0; options[i] != NULL && n < MAX_ARGS - 3; i++)
+  { args[n++] = options[i]; }
+  args[n++] = "-f";
+  args[n++] = name_input;
+  args[n] = NULL;
+
+  fprintf(stderr, "%s:", mode);
+  for (i = 0; i < n; i++) fprintf(stderr, " %s", args[i]);
+  fprintf(stderr, " > %s\n", name_output);
+  run_grepwalk(&r, args, name_input, name_output);
+  r.passes = stats != NULL ? read_passes(name_stats) : 1;
+  print_result(mode, &r);
+}
+
+
+int main(int argc, char *argv[])
+{
+  char merged[MAX_CHAR + 32];
+  char *count[] = {"-u", NULL};
+  char *trim[] = {"-t", NULL};
+  char *merge[] = {"-g", NULL, NULL};
+  char *walk[] = {NULL};
+  char *walk_a[] = {"-a", NULL};
+  char *walk_b[] = {"-B", "-a", NULL};
+  char *walk_d[] = {"-D", "-a", NULL};
+  char *walk_c[] = {"-C", "-a", NULL};
+  int opt;
+
+  while ((opt = getopt(argc, argv, "b:c:C:d:e:g:j:l:r:x:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'b': length_background = atol(optarg);
+                break;
+      case 'c': coverage_genome = atof(optarg);
+                break;
+      case 'C': coverage_background = atof(optarg);
+                break;
+      case 'd': strncpy(directory, optarg, MAX_CHAR - 1);
+                break;
+      case 'e': error_rate = atoi(optarg);
+                break;
+      case 'g': length_genome = atol(optarg);
+                break;
+      case 'j': strncpy(threads, optarg, MAX_CHAR - 1);
+                break;
+      case 'l': length_read = atoi(optarg);
+                break;
+      case 'r': random_seed = strtoul(optarg, NULL, 10);
+                break;
+      case 'x': strncpy(grepwalk, optarg, MAX_CHAR - 1);
+                break;
+      default:  fprintf(stderr, "Usage: grepwalk_bench [-b num] [-c num] "
+                        "[-C num] [-d dir] [-e num] [-g num] [-j num] "
+                        "[-l num] [-r num] [-x file]\n");
+                return EXIT_FAILURE;
+    }
+  }
+  if (length_read < 40 || length_read >= MAX_CHAR / 2 ||
+      length_genome < 2 * length_read || length_background < 0 ||
+      error_rate < 0 || error_rate > 5000)
+  {
+    fprintf(stderr, "grepwalk_bench: inappropriate parameters\n");
+    return EXIT_FAILURE;
+  }
+  state = random_seed * UINT64_C(0x9E3779B97F4A7C15) + 1;
+
+  fprintf(stderr, "grepwalk_bench: %ld pairs simulated\n", simulate_reads());
+
+  sprintf(merged, "%s/bench_t_2.fastq", directory);
+  merge[1] = merged;
+  fprintf(stdout, "#mode\tseconds\treads\tbytes\treads/s\tMB/s\tpasses\t"
+          "peak_rss_kB\tstatus\n");
+  run_mode("count", count, "bench_1.fastq", "bench_u.txt", NULL);
+  run_mode("trim_1", trim, "bench_1.fastq", "bench_t_1.fastq", NULL);
+  run_mode("trim_2", trim, "bench_2.fastq", "bench_t_2.fastq", NULL);
+  run_mode("merge", merge, "bench_t_1.fastq", "bench_m.fastq", NULL);
+  run_mode("walk", walk, "bench_m.fastq", "bench_w.fa",
+           "bench_w.tsv");
+  run_mode("walk_a", walk_a, "bench_m.fastq", "bench_wa.fa",
+           "bench_wa.tsv");
+  run_mode("walk_B", walk_b, "bench_m.fastq", "bench_wb.fa",
+           "bench_wb.tsv");
+  run_mode("walk_D", walk_d, "bench_m.fastq", "bench_wd.fa",
+           "bench_wd.tsv");
+  run_mode("walk_C", walk_c, "bench_m.fastq", "bench_wc.fa",
+           "bench_wc.tsv");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,631 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   kmer_index.c - index reads of a fastq or fasta file by their k-mers     */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from libgrepwalk.c and read_reads.c               */
+/*   when option -k is provided.                                             */
+/*   Every k-mer of every read is encoded with two bits per base and the     */
+/*   smaller one of the k-mer and its reverse complement is used as a key,   */
+/*   so that a read holding the seed on either strand can be looked up.      */
+/*   The index is saved into a file and reused by later runs.  When reads    */
+/*   have been appended to the file since it was indexed, e.g. another lane  */
+/*   of the library, only the reads appended are indexed and merged into     */
+/*   the index, which is saved again (see also option -E).                   */
+/*   With the index, each pass over the reads visits only reads holding      */
+/*   the first k bases of the current seed, in the same order as the file.   */
+/*                                                                           */
+/* FILE FORMAT                                                               */
+/*   INDEX_MAGIC, k, size and fingerprint of the indexed file, numbers of    */
+/*   reads, keys and postings, followed by the file positions of the reads,  */
+/*   the sorted keys, the first posting of each key, and the ordinal         */
+/*   numbers of the reads.  Integers are written in the byte order of the    */
+/*   machine.  The fingerprint hashes the first and the last SIZE_BLOCK      */
+/*   bytes indexed, so that another file of the same size is not taken.      */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Read entries with record_reader.c                         */
+/*   Oct 17, 2026  Keep the index in struct kmer_index for libgrepwalk       */
+/*   Oct 17, 2026  Index only the reads appended to the file since indexed   */
+/*   Oct 17, 2026  Check the index loaded; add the fingerprint of the file   */
+/*   Oct 17, 2026  Keep the file and the postings on the context for errors  */
+/*   Oct 17, 2026  Refuse more reads than the 32-bit ids of the postings     */
+/*                                                                           */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "defaults.h"
+#include "grepwalk.h"
+#include "examine_reads.h"
+#include "record_reader.h"
+
+#define MAX_KMER 32
+#define INDEX_MAGIC "GrepWalkIndex2\n"
+#define SIZE_MAGIC 16
+#define SIZE_BLOCK 4096
+
+
+void uc_only_tcag(char *);
+int read_record(struct record_reader *, char *, char *);
+struct record_reader *open_records(char *, int);
+long int tell_records(struct record_reader *);
+void seek_records(struct record_reader *, long int);
+int is_gzip(unsigned char *);
+void free_kmer_index(struct kmer_index *);
+void close_records(struct record_reader *);
+
+
+/**** the k-mer index ****/
+struct posting
+{
+  uint64_t key;
+  uint32_t id;
+};
+
+
+
+/*                                                                           */
+/* encode_kmer()                                                             */
+/*                                                                           */
+/*   This function encodes the first k bases of a sequence with two bits     */
+/*   per base and stores the smaller one of the code and the code of its     */
+/*   reverse complement.                                                     */
+/*   It returns 0 when the k bases include other than T, C, A, or G.         */
+/*                                                                           */
+int encode_kmer(char *seq, int k, uint64_t *key)
+{
+  int i, b;
+  uint64_t forward = 0, reverse = 0;
+
+  for (i = 0; i < k; i++)
+  {
+    switch (seq[i])
+    {
+      case 'A': b = 0; break;
+      case 'C': b = 1; break;
+      case 'G': b = 2; break;
+      case 'T': b = 3; break;
+      default:  return 0;
+    }
+    forward = (forward << 2) | (uint64_t)b;
+    reverse |= (uint64_t)(3 - b) << (2 * i);
+  }
+  *key = forward < reverse ? forward : reverse;
+  return 1;
+}
+
+
+int compare_postings(const void *a, const void *b)
+{
+  const struct posting *p = (const struct posting *)a;
+  const struct posting *q = (const struct posting *)b;
+
+  if (p->key != q->key) return p->key < q->key ? -1 : 1;
+  if (p->id != q->id) return p->id < q->id ? -1 : 1;
+  return 0;
+}
+
+
+long int size_of_file(FILE *fp)
+{
+  long int size;
+
+  fseek(fp, 0L, SEEK_END);
+  size = ftell(fp);
+  fseek(fp, 0L, SEEK_SET);
+  return size;
+}
+
+
+/*                                                                           */
+/* fingerprint_file()                                                        */
+/*                                                                           */
+/*   This function hashes the first and the last SIZE_BLOCK bytes of the     */
+/*   first size bytes of a file with FNV-1a.  Bytes appended after size do   */
+/*   not change the fingerprint.  The file is rewound.                       */
+/*                                                                           */
+uint64_t fingerprint_file(FILE *fp, long int size)
+{
+  unsigned char block[SIZE_BLOCK];
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  long int from[2];
+  size_t i, n;
+  int j;
+
+  from[0] = 0L;
+  from[1] = size > SIZE_BLOCK ? size - SIZE_BLOCK : 0L;
+  for (j = 0; j < 2; j++)
+  {
+    n = size - from[j] < SIZE_BLOCK ? (size_t)(size - from[j]) : SIZE_BLOCK;
+    if (fseek(fp, from[j], SEEK_SET) != 0 || fread(block, 1, n, fp) != n)
+    { n = 0; }	/* shorter than size; the size is compared anyway */
+    for (i = 0; i < n; i++)
+    { hash = (hash ^ block[i]) * 0x100000001b3ULL; }
+  }
+  fseek(fp, 0L, SEEK_SET);
+  return hash;
+}
+
+
+/*                                                                           */
+/* build_kmer_index()                                                        */
+/*                                                                           */
+/*   This function reads all the reads once and builds the index in memory.  */
+/*   The reads are read from the file position from, and numbered from       */
+/*   first; both are 0 unless the reads appended to a file are indexed.      */
+/*   The file and the postings are kept on the context and the index until   */
+/*   they are freed, so that an error does not leave them behind.            */
+/*   A read is numbered with 32 bits in the index, so a file of more than    */
+/*   UINT32_MAX reads cannot be indexed.                                     */
+/*                                                                           */
+int build_kmer_index(struct grepwalk *gw, struct kmer_index *x,
+                     char *name_fastq, int k, long int from, uint64_t first)
+{
+  int i, j, b, l;
+  uint64_t n = 0, size_postings = 0x10000, size_offsets = 0x10000;
+  uint64_t forward, reverse, mask;
+  char sequence[MAX_CHAR];
+  char qscores[MAX_CHAR];
+  struct posting *postings;
+  struct record_reader *fastq;
+  long int *offsets;
+  FILE *fp;
+
+  if ((fp = fopen(name_fastq, "r")) == NULL)
+  { ERROR_MESSAGE(222, name_fastq); }
+  x->size_indexed = size_of_file(fp);
+  x->fingerprint = fingerprint_file(fp, x->size_indexed);
+  fclose(fp);
+  if ((gw->fastq = open_records(name_fastq, gw->n_threads)) == NULL)
+  { ERROR_MESSAGE(222, name_fastq); }
+  fastq = gw->fastq;
+  if (from > 0) seek_records(fastq, from);
+
+  x->postings = (struct posting *)malloc(size_postings *
+                                         sizeof(struct posting));
+  x->offsets = (long int *)malloc(size_offsets * sizeof(long int));
+  if (x->postings == NULL || x->offsets == NULL)
+  { ERROR_MESSAGE(226, "memory allocation for the k-mer index"); }
+  mask = k == MAX_KMER ? ~(uint64_t)0 : ((uint64_t)1 << (2 * k)) - 1;
+
+  x->n_reads = 0;
+  for (;;)
+  {
+    if (x->n_reads == size_offsets)
+    {
+      size_offsets *= 2;
+      offsets = (long int *)realloc(x->offsets,
+                                    size_offsets * sizeof(long int));
+      if (offsets == NULL)
+      { ERROR_MESSAGE(226, "memory allocation for the k-mer index"); }
+      x->offsets = offsets;
+    }
+    x->offsets[x->n_reads] = tell_records(fastq);
+    if (read_record(fastq, sequence, qscores) == 0) break;
+    if (first + x->n_reads > UINT32_MAX)
+    {
+      fail_walk(225, "Reads to be indexed should be no more than %lu: %s",
+                (unsigned long int)UINT32_MAX + 1, name_fastq);
+    }
+    uc_only_tcag(sequence);
+
+    forward = reverse = 0;
+    for (i = j = 0, l = (int)strlen(sequence); i < l; i++)
+    {	/* j: number of successive bases that can be encoded */
+      switch (sequence[i])
+      {
+        case 'A': b = 0; break;
+        case 'C': b = 1; break;
+        case 'G': b = 2; break;
+        case 'T': b = 3; break;
+        default:  b = -1;
+      }
+      if (b < 0) { j = 0; continue; }
+      forward = ((forward << 2) | (uint64_t)b) & mask;
+      reverse = (reverse >> 2) | ((uint64_t)(3 - b) << (2 * (k - 1)));
+      if (++j < k) continue;
+
+      if (n == size_postings)
+      {
+        size_postings *= 2;
+        postings = (struct posting *)realloc(x->postings,
+                                   size_postings * sizeof(struct posting));
+        if (postings == NULL)
+        { ERROR_MESSAGE(226, "memory allocation for the k-mer index"); }
+        x->postings = postings;
+      }
+      x->postings[n].key = forward < reverse ? forward : reverse;
+      x->postings[n].id = (uint32_t)(first + x->n_reads);
+      n++;
+    }
+    x->n_reads++;
+  }
+  close_records(fastq);
+  gw->fastq = NULL;
+  postings = x->postings;
+
+  /**** sort the postings and remove duplicates within a read ****/
+
+  qsort(postings, (size_t)n, sizeof(struct posting), compare_postings);
+  x->keys = (uint64_t *)malloc((n + 1) * sizeof(uint64_t));
+  x->starts = (uint64_t *)malloc((n + 1) * sizeof(uint64_t));
+  x->ids = (uint32_t *)malloc((n + 1) * sizeof(uint32_t));
+  if (x->keys == NULL || x->starts == NULL || x->ids == NULL)
+  { ERROR_MESSAGE(226, "memory allocation for the k-mer index"); }
+
+  x->n_keys = x->n_postings = 0;
+  for (size_postings = 0; size_postings < n; size_postings++)
+  {
+    if (x->n_postings > 0 &&
+        postings[size_postings].key == postings[size_postings - 1].key &&
+        postings[size_postings].id == postings[size_postings - 1].id)
+    { continue; }
+    if (x->n_keys == 0 ||
+        postings[size_postings].key != x->keys[x->n_keys - 1])
+    {
+      x->keys[x->n_keys] = postings[size_postings].key;
+      x->starts[x->n_keys++] = x->n_postings;
+    }
+    x->ids[x->n_postings++] = postings[size_postings].id;
+  }
+  x->starts[x->n_keys] = x->n_postings;
+  free(postings);
+  x->postings = NULL;
+  x->k = k;
+  return EXIT_SUCCESS;
+}
+
+
+/*                                                                           */
+/* grown_kmer_index()                                                        */
+/*                                                                           */
+/*   This function is called when the file of reads is larger than it was    */
+/*   when indexed.  It returns 1 if reads seem to have been appended to the  */
+/*   file, i.e. the file is not compressed, the indexed part ends with a     */
+/*   line, and the last indexed read is still there; otherwise 0.            */
+/*                                                                           */
+int grown_kmer_index(struct kmer_index *x, FILE *fp)
+{
+  unsigned char magic[2];
+  int c;
+
+  if (fread(magic, 1, 2, fp) != 2 || is_gzip(magic)) return 0;
+  if (x->size_indexed > 0)
+  {
+    fseek(fp, x->size_indexed - 1, SEEK_SET);
+    if (fgetc(fp) != '\n') return 0;
+  }
+  if (x->n_reads > 0)
+  {
+    fseek(fp, x->offsets[x->n_reads - 1], SEEK_SET);
+    if ((c = fgetc(fp)) != '@' && c != '>') return 0;
+  }
+  return 1;
+}
+
+
+/*                                                                           */
+/* merge_kmer_index()                                                        */
+/*                                                                           */
+/*   This function merges the index of the reads appended, y, into x.  The   */
+/*   reads of y follow those of x, so the postings of a key are those of x   */
+/*   followed by those of y, in ascending order.  y is x->appended, which    */
+/*   is freed.                                                               */
+/*                                                                           */
+int merge_kmer_index(struct kmer_index *x)
+{
+  uint64_t i = 0, j = 0, n_keys = 0, n_postings = 0, key, l;
+  uint64_t *keys, *starts;
+  uint32_t *ids;
+  long int *offsets;
+  struct kmer_index *y = x->appended;
+
+  keys = (uint64_t *)malloc((x->n_keys + y->n_keys + 1) * sizeof(uint64_t));
+  starts = (uint64_t *)malloc((x->n_keys + y->n_keys + 1) * sizeof(uint64_t));
+  ids = (uint32_t *)malloc((x->n_postings + y->n_postings + 1) *
+                           sizeof(uint32_t));
+  offsets = (long int *)realloc(x->offsets,
+              (x->n_reads + y->n_reads + 1) * sizeof(long int));
+  if (offsets != NULL) x->offsets = offsets;
+  if (keys == NULL || starts == NULL || ids == NULL || offsets == NULL)
+  {
+    free(keys); free(starts); free(ids);
+    ERROR_MESSAGE(226, "memory allocation for the k-mer index");
+  }
+
+  while (i < x->n_keys || j < y->n_keys)
+  {
+    if (j == y->n_keys || (i < x->n_keys && x->keys[i] < y->keys[j]))
+    { key = x->keys[i]; }
+    else { key = y->keys[j]; }
+    keys[n_keys] = key;
+    starts[n_keys++] = n_postings;
+    if (i < x->n_keys && x->keys[i] == key)
+    {
+      l = x->starts[i + 1] - x->starts[i];
+      memcpy(ids + n_postings, x->ids + x->starts[i], l * sizeof(uint32_t));
+      n_postings += l;
+      i++;
+    }
+    if (j < y->n_keys && y->keys[j] == key)
+    {
+      l = y->starts[j + 1] - y->starts[j];
+      memcpy(ids + n_postings, y->ids + y->starts[j], l * sizeof(uint32_t));
+      n_postings += l;
+      j++;
+    }
+  }
+  starts[n_keys] = n_postings;
+  memcpy(x->offsets + x->n_reads, y->offsets, y->n_reads * sizeof(long int));
+
+  free(x->keys);
+  free(x->starts);
+  free(x->ids);
+  x->keys = keys;
+  x->starts = starts;
+  x->ids = ids;
+  x->n_keys = n_keys;
+  x->n_postings = n_postings;
+  x->n_reads += y->n_reads;
+  x->size_indexed = y->size_indexed;
+  x->fingerprint = y->fingerprint;
+  free_kmer_index(y);
+  x->appended = NULL;
+  return EXIT_SUCCESS;
+}
+
+
+int save_kmer_index(struct kmer_index *x, char *name_index)
+{
+  FILE *fp;
+  char magic[SIZE_MAGIC] = INDEX_MAGIC;
+
+  if ((fp = fopen(name_index, "wb")) == NULL)
+  { ERROR_MESSAGE(224, name_index); }
+  if (fwrite(magic, 1, SIZE_MAGIC, fp) != SIZE_MAGIC ||
+      fwrite(&x->k, sizeof(int), 1, fp) != 1 ||
+      fwrite(&x->size_indexed, sizeof(long int), 1, fp) != 1 ||
+      fwrite(&x->fingerprint, sizeof(uint64_t), 1, fp) != 1 ||
+      fwrite(&x->n_reads, sizeof(uint64_t), 1, fp) != 1 ||
+      fwrite(&x->n_keys, sizeof(uint64_t), 1, fp) != 1 ||
+      fwrite(&x->n_postings, sizeof(uint64_t), 1, fp) != 1 ||
+      fwrite(x->offsets, sizeof(long int), x->n_reads, fp)
+        != x->n_reads ||
+      fwrite(x->keys, sizeof(uint64_t), x->n_keys, fp)
+        != x->n_keys ||
+      fwrite(x->starts, sizeof(uint64_t), x->n_keys + 1, fp)
+        != x->n_keys + 1 ||
+      fwrite(x->ids, sizeof(uint32_t), x->n_postings, fp) != x->n_postings)
+  { fclose(fp); ERROR_MESSAGE(224, name_index); }
+  fclose(fp);
+  return EXIT_SUCCESS;
+}
+
+
+/*                                                                           */
+/* check_kmer_index()                                                        */
+/*                                                                           */
+/*   This function checks that an index loaded can be walked on safely,      */
+/*   i.e. the reads are in the indexed part of the file in ascending order,  */
+/*   the keys are k-mers in ascending order, the postings of each key are    */
+/*   within the index, and the reads of each key are in ascending order.     */
+/*   It returns 1 if so, or 0 if the index is broken.                        */
+/*                                                                           */
+int check_kmer_index(struct kmer_index *x)
+{
+  uint64_t i, j, mask;
+
+  if (x->k < 1 || MAX_KMER < x->k) return 0;
+  mask = x->k == MAX_KMER ? ~(uint64_t)0 : ((uint64_t)1 << (2 * x->k)) - 1;
+  for (i = 0; i < x->n_reads; i++)
+  {
+    if (x->offsets[i] < 0 || x->offsets[i] >= x->size_indexed) return 0;
+    if (i > 0 && x->offsets[i] <= x->offsets[i - 1]) return 0;
+  }
+  if (x->starts[0] != 0 || x->starts[x->n_keys] != x->n_postings) return 0;
+  for (i = 0; i < x->n_keys; i++)
+  {
+    if (x->keys[i] > mask || (i > 0 && x->keys[i] <= x->keys[i - 1]) ||
+        x->starts[i + 1] <= x->starts[i] || x->starts[i + 1] > x->n_postings)
+    { return 0; }
+    for (j = x->starts[i]; j < x->starts[i + 1]; j++)
+    {
+      if (x->ids[j] >= x->n_reads) return 0;
+      if (j > x->starts[i] && x->ids[j] <= x->ids[j - 1]) return 0;
+    }
+  }
+  return 1;
+}
+
+
+/*                                                                           */
+/* load_kmer_index()                                                         */
+/*                                                                           */
+/*   This function loads an index saved by save_kmer_index().  The numbers   */
+/*   in the header are checked against the size of the index file before     */
+/*   memory is allocated, and the arrays by check_kmer_index() after.        */
+/*   The file is closed before an error is raised; the arrays are freed      */
+/*   with the index on the context.                                          */
+/*                                                                           */
+int load_kmer_index(struct kmer_index *x, FILE *fp, char *name_index)
+{
+  char magic[SIZE_MAGIC];
+  long int size_header;
+  uint64_t size;
+
+  if (fread(magic, 1, SIZE_MAGIC, fp) != SIZE_MAGIC ||
+      strncmp(magic, INDEX_MAGIC, SIZE_MAGIC) ||
+      fread(&x->k, sizeof(int), 1, fp) != 1 ||
+      fread(&x->size_indexed, sizeof(long int), 1, fp) != 1 ||
+      fread(&x->fingerprint, sizeof(uint64_t), 1, fp) != 1 ||
+      fread(&x->n_reads, sizeof(uint64_t), 1, fp) != 1 ||
+      fread(&x->n_keys, sizeof(uint64_t), 1, fp) != 1 ||
+      fread(&x->n_postings, sizeof(uint64_t), 1, fp) != 1)
+  { fclose(fp); ERROR_MESSAGE(225, name_index); }
+
+  /**** the arrays should fill the rest of the file exactly ****/
+  size_header = ftell(fp);
+  size = (uint64_t)(size_of_file(fp) - size_header);
+  fseek(fp, size_header, SEEK_SET);
+  if (x->size_indexed < 0 || x->n_reads > size || x->n_keys >= size ||
+      x->n_postings > size ||
+      x->n_reads * sizeof(long int) + (2 * x->n_keys + 1) * sizeof(uint64_t)
+        + x->n_postings * sizeof(uint32_t) != size)
+  {
+    fclose(fp);
+    fail_walk(225, "The index is broken: %s", name_index);
+  }
+
+  x->offsets = (long int *)malloc((x->n_reads + 1) * sizeof(long int));
+  x->keys = (uint64_t *)malloc((x->n_keys + 1) * sizeof(uint64_t));
+  x->starts = (uint64_t *)malloc((x->n_keys + 1) * sizeof(uint64_t));
+  x->ids = (uint32_t *)malloc((x->n_postings + 1) * sizeof(uint32_t));
+  if (x->offsets == NULL || x->keys == NULL ||
+      x->starts == NULL || x->ids == NULL)
+  { fclose(fp); ERROR_MESSAGE(226, "memory allocation for the k-mer index"); }
+
+  if (fread(x->offsets, sizeof(long int), x->n_reads, fp)
+        != x->n_reads ||
+      fread(x->keys, sizeof(uint64_t), x->n_keys, fp)
+        != x->n_keys ||
+      fread(x->starts, sizeof(uint64_t), x->n_keys + 1, fp)
+        != x->n_keys + 1 ||
+      fread(x->ids, sizeof(uint32_t), x->n_postings, fp) != x->n_postings ||
+      !check_kmer_index(x))
+  {
+    fclose(fp);
+    fail_walk(225, "The index is broken: %s", name_index);
+  }
+  return EXIT_SUCCESS;
+}
+
+
+void free_kmer_index(struct kmer_index *x)
+{
+  if (x->appended != NULL) free_kmer_index(x->appended);
+  free(x->postings);
+  free(x->offsets);
+  free(x->keys);
+  free(x->starts);
+  free(x->ids);
+  free(x);
+}
+
+
+/*                                                                           */
+/* prepare_kmer_index()                                                      */
+/*                                                                           */
+/*   This function is called from index_reads() when option -k is given.     */
+/*   If the index file exists, it is loaded; otherwise the index is built    */
+/*   from the fastq or fasta file and saved into the index file.  If reads   */
+/*   have been appended to the file, they are indexed and the index is       */
+/*   saved again.                                                            */
+/*   The k-mer length is the shortest one of the seeds, the seed after the   */
+/*   first extension (window - slide), and MAX_KMER.                         */
+/*                                                                           */
+int prepare_kmer_index(struct grepwalk *gw, char *name_index, char *name_fastq)
+{
+  int i, k = gw->window - gw->slide;
+  long int size;
+  struct kmer_index *x;
+  FILE *fp;
+
+  for (i = 0; i < gw->n_walkers; i++)
+  { if (gw->walkers[i].length_seed < k) k = gw->walkers[i].length_seed; }
+  if (MAX_KMER < k) k = MAX_KMER;
+
+  if (gw->index != NULL)
+  {	/* left by an error; never shared (see index_reads()) */
+    free_kmer_index(gw->index);
+    gw->index = NULL;
+  }
+  x = (struct kmer_index *)calloc(1, sizeof(struct kmer_index));
+  if (x == NULL)
+  { ERROR_MESSAGE(226, "memory allocation for the k-mer index"); }
+  gw->index = x;
+  if ((fp = fopen(name_index, "rb")) == NULL)
+  {
+    build_kmer_index(gw, x, name_fastq, k, 0L, 0);
+    return save_kmer_index(x, name_index);
+  }
+  load_kmer_index(x, fp, name_index);
+  fclose(fp);
+  if (x->k > k)
+  {
+    fail_walk(225, "K-mers in the index (%d) should not be longer "
+                   "than the seed (%d).", x->k, k);
+  }
+
+  if ((fp = fopen(name_fastq, "r")) == NULL)
+  { ERROR_MESSAGE(222, name_fastq); }
+  size = size_of_file(fp);
+  if (size < x->size_indexed ||
+      fingerprint_file(fp, x->size_indexed) != x->fingerprint ||
+      (size > x->size_indexed && !grown_kmer_index(x, fp)))
+  {
+    fclose(fp);
+    fail_walk(225, "The index does not match the file: %s", name_fastq);
+  }
+  fclose(fp);
+  if (size == x->size_indexed) return EXIT_SUCCESS;
+
+  /**** index the reads appended to the file, and merge them ****/
+
+  x->appended = (struct kmer_index *)calloc(1, sizeof(struct kmer_index));
+  if (x->appended == NULL)
+  { ERROR_MESSAGE(226, "memory allocation for the k-mer index"); }
+  build_kmer_index(gw, x->appended, name_fastq, x->k, x->size_indexed,
+                   x->n_reads);
+  merge_kmer_index(x);
+  return save_kmer_index(x, name_index);
+}
+
+
+/*                                                                           */
+/* next_indexed_read()                                                       */
+/*                                                                           */
+/*   This function returns the ordinal number of the first read, not less    */
+/*   than from, that holds the first k bases of the seed on either strand.   */
+/*   It returns -1 when there is no such read.                               */
+/*   When the seed cannot be encoded, every read is a candidate.             */
+/*                                                                           */
+long int next_indexed_read(struct kmer_index *x, char *seed, long int from)
+{
+  uint64_t key, low, high, middle, end;
+
+  if ((uint64_t)from >= x->n_reads) return -1;
+  if (encode_kmer(seed, x->k, &key) == 0) return from;
+
+  low = 0; high = x->n_keys;
+  while (low < high)
+  {
+    middle = low + (high - low) / 2;
+    if (x->keys[middle] < key) low = middle + 1;
+    else high = middle;
+  }
+  if (low == x->n_keys || x->keys[low] != key) return -1;
+
+  high = end = x->starts[low + 1];
+  low = x->starts[low];
+  while (low < high)
+  {
+    middle = low + (high - low) / 2;
+    if ((long int)x->ids[middle] < from) low = middle + 1;
+    else high = middle;
+  }
+  if (low == end) return -1;
+  return (long int)x->ids[low];
+}
+
+
+long int indexed_read_offset(struct kmer_index *x, long int id)
+{
+  return x->offsets[id];
+}
@@ -0,0 +1,354 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   libgrepwalk.c - run a walk on a context instead of global variables     */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from grepwalk.c, which is a thin wrapper of the   */
+/*   functions below, and may be called from other programs linked with      */
+/*   libgrepwalk.a.  The parameters, the seeds, the nominee tables, the      */
+/*   reads kept or indexed, and the output streams of a walk are held in     */
+/*   struct grepwalk (see grepwalk.h), so that walks from two or more        */
+/*   contexts can run at the same time in their own threads.                 */
+/*   An error found by ERROR_MESSAGE or fail_walk() in a function called     */
+/*   from here returns from that function with the exit status that the      */
+/*   grepwalk command would have, and the message is left in gw->message;    */
+/*   elsewhere, e.g. in trimming or merging, the message is printed and the  */
+/*   process exits as before.                                                */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Free the reads kept and held with option -D               */
+/*   Oct 17, 2026  The read store is given the window as well                */
+/*   Oct 17, 2026  Free the k-mers hashed with option -C                     */
+/*   Oct 17, 2026  Check the options of a checkpoint (-F, -R)                */
+/*   Oct 17, 2026  Option -E; add the reads of another file to those kept    */
+/*   Oct 17, 2026  Keep the file loaded on the context; close files left     */
+/*   Oct 17, 2026  Do not load or index reads shared from another context    */
+/*                                                                           */
+
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "defaults.h"
+#include "grepwalk.h"
+#include "examine_reads.h"
+#include "record_reader.h"
+
+
+void uc_only_tcag(char *);
+int complementary_sequence(char *);
+struct walker *add_walker(struct grepwalk *, char *, char *);
+int read_reads(struct grepwalk *, char *);
+struct read_store *new_read_store(int, int);
+void free_read_store(struct read_store *);
+long int load_read_store(struct read_store *, struct record_reader *);
+int prepare_kmer_index(struct grepwalk *, char *, char *);
+void free_kmer_index(struct kmer_index *);
+void open_walk_stats(struct walk_stats *, char *);
+void close_walk_stats(struct walk_stats *);
+struct record_reader *open_records(char *, int);
+void close_records(struct record_reader *);
+void free_working_set(struct working_set *);
+
+
+_Thread_local struct grepwalk *catching = NULL;
+	/* the context whose function is running in this thread, if any */
+
+
+/*                                                                           */
+/* fail_walk()                                                               */
+/*                                                                           */
+/*   This function formats an error message like printf().  If a function    */
+/*   of this module is running in the thread, the message is kept in the     */
+/*   context and the function returns code; otherwise the message is         */
+/*   printed onto the standard error output and the process exits.           */
+/*                                                                           */
+void fail_walk(int code, const char *format, ...)
+{
+  struct grepwalk *gw = catching;
+  va_list ap;
+
+  va_start(ap, format);
+  if (gw == NULL)
+  {
+    vfprintf(stderr, format, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+    exit(code);
+  }
+  vsnprintf(gw->message, MAX_CHAR, format, ap);
+  va_end(ap);
+  gw->code = code;
+  longjmp(gw->jump, 1);
+}
+
+
+/****  every function below calls setjmp() and enter_walk() first  ****/
+void enter_walk(struct grepwalk *gw)
+{
+  gw->code = 0;
+  gw->message[0] = '\0';
+  catching = gw;
+  if (gw->fastq != NULL)
+  {	/* left open by an error */
+    close_records(gw->fastq);
+    gw->fastq = NULL;
+  }
+  if (gw->checkpoint_file != NULL)
+  {
+    fclose(gw->checkpoint_file);
+    gw->checkpoint_file = NULL;
+  }
+}
+
+
+int leave_walk(struct grepwalk *gw)
+{
+  catching = NULL;
+  return gw->code;
+}
+
+
+/*                                                                           */
+/* init_grepwalk()                                                           */
+/*                                                                           */
+/*   This function prepares a context with the default parameters, which     */
+/*   may be changed before the first seed is added.                          */
+/*                                                                           */
+void init_grepwalk(struct grepwalk *gw)
+{
+  memset(gw, 0, sizeof(*gw));
+  gw->window = DEFAULT_WINDOW;
+  gw->slide = DEFAULT_SLIDE;
+  gw->minimum_qscore = DEFAULT_MIN_QSCORE;
+  gw->strand_depth = DEFAULT_STRAND_DEPTH;
+  gw->maximum_length = DEFAULT_MAX_LENGTH;
+  gw->n_columns = DEFAULT_N_COLUMNS;
+  gw->n_threads = DEFAULT_THREADS;
+  gw->output = stdout;
+  gw->nominees = stderr;
+  gw->own_reads = 1;
+  gw->stats.phase = PHASE_PREPARE;
+}
+
+
+/*                                                                           */
+/* check_grepwalk()                                                          */
+/*                                                                           */
+/*   This function checks the sizes of the window and the slide, the         */
+/*   number of threads, and the options of a checkpoint.  It returns 0, or   */
+/*   the exit status.                                                        */
+/*                                                                           */
+int check_grepwalk(struct grepwalk *gw)
+{
+  gw->code = 0;
+  if (gw->slide >= gw->window)
+  {
+    sprintf(gw->message,
+      "Sliding size (%d) should be less than the window size (%d).",
+      gw->slide, gw->window);
+    gw->code = 203;
+  }
+  else if (gw->n_threads < 1 || gw->n_threads > MAX_THREADS)
+  {
+    sprintf(gw->message,
+      "Number of threads (%d) should be from 1 to %d.",
+      gw->n_threads, MAX_THREADS);
+    gw->code = 227;
+  }
+  else if ((gw->resuming || gw->extending) && gw->checkpoint[0] == '\0')
+  {
+    sprintf(gw->message, "Options -R and -E should be used with option -F.");
+    gw->code = 232;
+  }
+  else if (gw->checkpoint[0] != '\0' && gw->dropping)
+  {
+    sprintf(gw->message, "Option -F cannot be used with option -D.");
+    gw->code = 232;
+  }
+  return gw->code;
+}
+
+
+/*                                                                           */
+/* add_seed()                                                                */
+/*                                                                           */
+/*   This function checks the length and the sequence of a seed, and adds    */
+/*   a walker for it, complemented if gw->complement is 1 (option -c).       */
+/*   The seed given is not changed.                                          */
+/*                                                                           */
+int add_seed(struct grepwalk *gw, char *name, char *seed)
+{
+  int i, length = strlen(seed);
+  char sequence[MAX_CHAR];
+
+  if (setjmp(gw->jump)) return leave_walk(gw);
+  enter_walk(gw);
+  if (length >= gw->window)
+  {
+    fail_walk(202,
+      "Seed length (%d) should be less than the window size (%d).",
+      length, gw->window);
+  }
+  strcpy(sequence, seed);
+  uc_only_tcag(sequence);
+  for (i = 0; sequence[i] != '\0'; i++)
+  {
+    if (sequence[i] != 'T' && sequence[i] != 'C' &&
+        sequence[i] != 'A' && sequence[i] != 'G')
+    {
+      fail_walk(205,
+        "Seed sequence (%s) should consists of only T, C, A, or G.",
+        sequence);
+    }
+  }
+  if (gw->complement == 1) complementary_sequence(sequence);
+  add_walker(gw, name, sequence);
+  return leave_walk(gw);
+}
+
+
+/*                                                                           */
+/* load_reads()                                                              */
+/*                                                                           */
+/*   This function keeps all the reads of a fastq or fasta file in memory    */
+/*   (option -a), so that the file is read only once.  Called again, it      */
+/*   adds the reads of another file, e.g. another lane of the library,       */
+/*   after those kept.  Reads shared from another context cannot be added    */
+/*   to, as the other walks may be reading them.                             */
+/*                                                                           */
+int load_reads(struct grepwalk *gw, char *name_fastq)
+{
+  if (setjmp(gw->jump)) return leave_walk(gw);
+  enter_walk(gw);
+  if (!gw->own_reads)
+  {
+    fail_walk(222, "The reads are shared from another context: %s",
+              name_fastq);
+  }
+  if (gw->store == NULL)
+  { gw->store = new_read_store(gw->minimum_qscore, gw->window); }
+  if ((gw->fastq = open_records(name_fastq, gw->n_threads)) == NULL)
+  { fail_walk(222, "File open error: %s", name_fastq); }
+  load_read_store(gw->store, gw->fastq);
+  close_records(gw->fastq);
+  gw->fastq = NULL;
+  return leave_walk(gw);
+}
+
+
+/*                                                                           */
+/* index_reads()                                                             */
+/*                                                                           */
+/*   This function loads the k-mer index of a fastq or fasta file, or        */
+/*   builds and saves it (option -k).  It is called after the seeds are      */
+/*   added, as the k-mers are not longer than the shortest seed.             */
+/*   A context sharing the reads of another cannot index them again.         */
+/*                                                                           */
+int index_reads(struct grepwalk *gw, char *name_index, char *name_fastq)
+{
+  if (setjmp(gw->jump)) return leave_walk(gw);
+  enter_walk(gw);
+  if (!gw->own_reads)
+  {
+    fail_walk(225, "The reads are shared from another context: %s",
+              name_index);
+  }
+  prepare_kmer_index(gw, name_index, name_fastq);
+  return leave_walk(gw);
+}
+
+
+/*                                                                           */
+/* share_reads()                                                             */
+/*                                                                           */
+/*   This function lets a context walk on the reads kept or indexed by       */
+/*   another, which should not be freed until the walk is over.  The reads   */
+/*   are only read by the walks, so walks can share them at the same time.   */
+/*   The walk should have the same minimum_qscore and window as the one      */
+/*   that kept the reads, with which their quality scores were examined.     */
+/*   load_reads() and index_reads() fail on a context sharing the reads.     */
+/*                                                                           */
+void share_reads(struct grepwalk *gw, struct grepwalk *from)
+{
+  gw->store = from->store;
+  gw->index = from->index;
+  gw->own_reads = 0;
+}
+
+
+/*                                                                           */
+/* write_walk_stats()                                                        */
+/*                                                                           */
+/*   This function starts to write the rows of option -T into a file.        */
+/*                                                                           */
+int write_walk_stats(struct grepwalk *gw, char *name_stats)
+{
+  if (setjmp(gw->jump)) return leave_walk(gw);
+  enter_walk(gw);
+  open_walk_stats(&gw->stats, name_stats);
+  return leave_walk(gw);
+}
+
+
+/*                                                                           */
+/* walk_reads()                                                              */
+/*                                                                           */
+/*   This function walks from the seeds on the reads of a fastq or fasta     */
+/*   file, or on the reads kept in memory if any, and prints the sequences   */
+/*   onto gw->output.  A context walks only once.                            */
+/*                                                                           */
+int walk_reads(struct grepwalk *gw, char *name_fastq)
+{
+  if (check_grepwalk(gw) != 0) return gw->code;
+  if (setjmp(gw->jump)) return leave_walk(gw);
+  enter_walk(gw);
+  read_reads(gw, name_fastq);
+  return leave_walk(gw);
+}
+
+
+/*                                                                           */
+/* free_grepwalk()                                                           */
+/*                                                                           */
+/*   This function frees the memory and closes the files of a context,       */
+/*   including those left by an error.  The reads are freed unless shared.   */
+/*                                                                           */
+void free_grepwalk(struct grepwalk *gw)
+{
+  int i;
+  struct walker *w;
+
+  for (i = 0; i < gw->n_walkers; i++)
+  {
+    w = gw->walkers + i;
+    if (w->output != NULL && w->output != gw->output) fclose(w->output);
+    free(w->table);
+    free(w->slots);
+    free(w->contig);
+    free(w->held);
+    free(w->kmers);
+  }
+  free(gw->walkers);
+  free(gw->batch);
+  free(gw->hits);
+  if (gw->fastq != NULL) close_records(gw->fastq);
+  if (gw->checkpoint_file != NULL) fclose(gw->checkpoint_file);
+  close_walk_stats(&gw->stats);
+  free_working_set(&gw->set);
+  if (gw->own_reads && gw->store != NULL) free_read_store(gw->store);
+  if (gw->own_reads && gw->index != NULL) free_kmer_index(gw->index);
+  gw->walkers = NULL;
+  gw->n_walkers = 0;
+  gw->batch = NULL;
+  gw->hits = NULL;
+  gw->fastq = NULL;
+  gw->checkpoint_file = NULL;
+  gw->store = NULL;
+  gw->index = NULL;
+}
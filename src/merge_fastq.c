@@ -4,7 +4,10 @@
 /*                                                                           */
 /* DESCRIPTION                                                               */
 /*   This module is called from grepwalk.c                                   */
-/*   when option -i, -g, or -u is provided.                                  */
+/*   when option -g is provided, with option -i or not.                      */
+/*   Pairs of entries are taken in batches, and each of the n_threads        */
+/*   threads merges its own part of a batch into its own text.  The texts    */
+/*   are then written in the order of the input.                             */
 /*                                                                           */
 /* AUTHOR                                                                    */
 /*   Coded by Kohji OKAMURA, Ph.D.                                           */
@@ -22,20 +25,73 @@
 /*   May 11, 2015  Move trim_low_quality_bases() into diverged trim_bases.c  */
 /*   May 13, 2015  Move count_reads_bases() into diverged count_bases.c      */
 /*   May 17, 2015  Include defaults.h                                        */
+/*   Oct 17, 2026  Read entries with record_reader.c                         */
+/*   Oct 17, 2026  Write the output through bgzf.c (option -z)               */
+/*   Oct 17, 2026  Merge batches of pairs in threads (option -j)             */
+/*   Oct 17, 2026  Search overlaps in bit planes with mismatches (option -M) */
 /*                                                                           */
 
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <zlib.h>
 #include "defaults.h"
+#include "record_reader.h"
+#include "bgzf.h"
+
+#define SIZE_BATCH 0x1000
+#define WORDS (MAX_CHAR / 64 + 1)	/* one more for shifted_word() */
+#define MIN_PIECE 8	/* shorter pieces are not searched for */
 
 
 extern short int id;
+extern short int compress_output;
+extern int n_threads;
+extern int maximum_mismatches;
 
 void uc_only_tcag(char *);
 int reverse_sequence(char *);
 int complementary_sequence(char *);
+struct record_reader *open_records(char *, int);
+int next_records(struct record_reader *, struct record *, int);
+void close_records(struct record_reader *);
+void seek_records(struct record_reader *, long int);
+struct bgzf_output *open_output(FILE *, short int, int);
+void write_output(struct bgzf_output *, char *, size_t);
+void close_output(struct bgzf_output *);
+void append_text(struct text *, char *, size_t);
+
+
+/**** a sequence in bit planes ****/
+struct planes
+{
+  uint64_t low[WORDS];		/* C or T */
+  uint64_t high[WORDS];		/* G or T */
+  uint64_t other[WORDS];	/* N */
+};
+
+/**** pairs of entries merged by one thread ****/
+struct part
+{
+  struct record *records1;
+  struct record *records2;
+  int first;
+  int last;
+  int min_overlap;
+  int broken;		/* position of a broken pair, or -1 */
+  struct text text;
+};
+
+
+struct part merge_parts[MAX_THREADS];
+
+const unsigned char base_planes[256] =
+{	/* bits of low, high, and other planes, with 8 for a valid base */
+  ['A'] = 8, ['C'] = 9, ['G'] = 10, ['T'] = 11, ['N'] = 12
+};
 
 
 /*                                                                           */
@@ -70,175 +126,365 @@ int check_repeats(char *overlap, int length_overlap)
 
 
 /*                                                                           */
-/* merge_fastq()                                                             */
+/* print_entry()                                                             */
 /*                                                                           */
-/*   This function is called by main() when another file name is provided    */
-/*   with option -g.                                                         */
-/*   The output FASTQ is printed onto the standard output.                   */
+/*   This function appends to a text an entry with the header and the third  */
+/*   line of an input entry, and the given sequence and quality scores.      */
 /*                                                                           */
-int merge_fastq(char *name_fastq_r1, char *name_fastq_r2, int min_overlap)
+void print_entry(struct text *t, struct record *r,
+                 char *sequence, char *qscores)
+{
+  append_text(t, r->header, r->length_header);
+  append_text(t, "\n", 1);
+  append_text(t, sequence, strlen(sequence));
+  append_text(t, "\n", 1);
+  append_text(t, r->third, r->length_third);
+  append_text(t, "\n", 1);
+  append_text(t, qscores, strlen(qscores));
+  append_text(t, "\n", 1);
+}
+
+
+/*                                                                           */
+/* print_ids()                                                               */
+/*                                                                           */
+/*   This function appends the headers of two entries merged (option -i).    */
+/*                                                                           */
+void print_ids(struct text *t, struct record *r1, struct record *r2)
+{
+  append_text(t, r1->header, r1->length_header);
+  append_text(t, "\n", 1);
+  append_text(t, r2->header, r2->length_header);
+  append_text(t, "\n", 1);
+}
+
+
+/*                                                                           */
+/* copy_entry()                                                              */
+/*                                                                           */
+/*   This function copies the sequence of an entry, and its quality scores   */
+/*   cut to the length of the sequence, into strings of MAX_CHAR bytes.      */
+/*   It returns 0 if the entry is not of fastq or too long.                  */
+/*                                                                           */
+int copy_entry(struct record *r, char *sequence, char *qscores)
+{
+  int length = r->length_sequence;
+
+  if (r->header[0] != '@' || r->qscores == NULL || length >= MAX_CHAR)
+  { return 0; }
+  memcpy(sequence, r->sequence, length);
+  sequence[length] = '\0';
+  if (r->length_qscores < length) length = r->length_qscores;
+  memcpy(qscores, r->qscores, length);
+  qscores[length] = '\0';
+  return 1;
+}
+
+
+/*                                                                           */
+/* encode_planes()                                                           */
+/*                                                                           */
+/*   This function encodes a sequence into three bit planes, in which bit i  */
+/*   of word i / 64 stands for base i: the two bits of T, C, A, or G, and    */
+/*   one bit for N.  It returns 0 if another character is found.             */
+/*                                                                           */
+int encode_planes(char *sequence, int length, struct planes *p)
+{
+  int i, code;
+  uint64_t low = 0, high = 0, other = 0;
+
+  memset(p, 0, sizeof(*p));
+  for (i = 0; i < length; i++)
+  {
+    if (((code = base_planes[(unsigned char)sequence[i]]) & 8) == 0) return 0;
+    low |= (uint64_t)(code & 1) << (i % 64);
+    high |= (uint64_t)((code >> 1) & 1) << (i % 64);
+    other |= (uint64_t)((code >> 2) & 1) << (i % 64);
+    if (i % 64 == 63 || i + 1 == length)
+    {
+      p->low[i / 64] = low;
+      p->high[i / 64] = high;
+      p->other[i / 64] = other;
+      low = high = other = 0;
+    }
+  }
+  return 1;
+}
+
+
+/*                                                                           */
+/* find_pieces()                                                             */
+/*                                                                           */
+/*   This function divides the last min_overlap bases of read 1 into         */
+/*   maximum_mismatches + 1 pieces, one of which should be found in read 2   */
+/*   if they overlap.  It returns 0 when none is found, or else 1, which is  */
+/*   also returned when the pieces are too short to be searched for.         */
+/*                                                                           */
+int find_pieces(char *sequence1, int len1, char *sequence2, int min_overlap)
+{
+  int i, n = maximum_mismatches + 1, size = min_overlap / n;
+  char piece[MAX_CHAR];
+
+  if (size < MIN_PIECE) return 1;
+  for (i = 0; i < n; i++)
+  {
+    memcpy(piece, sequence1 + len1 - min_overlap + i * size, size);
+    piece[size] = '\0';
+    if (strstr(sequence2, piece) != NULL) return 1;
+  }
+  return 0;
+}
+
+
+uint64_t shifted_word(uint64_t *plane, int position)
+{
+  int w = position / 64, r = position % 64;
+
+  return r == 0 ? plane[w] : (plane[w] >> r) | (plane[w + 1] << (64 - r));
+}
+
+
+/*                                                                           */
+/* count_mismatches()                                                        */
+/*                                                                           */
+/*   This function counts mismatches between length bases of sequence 1      */
+/*   from start and the first length bases of sequence 2, 64 bases at a      */
+/*   time.  Counting stops as soon as the number exceeds budget.  Without    */
+/*   planes (NULL), the characters are compared one by one.                  */
+/*                                                                           */
+int count_mismatches(struct planes *p1, struct planes *p2, char *sequence1,
+                     char *sequence2, int start, int length, int budget)
+{
+  int i, n = 0;
+  uint64_t diff;
+
+  if (p1 == NULL || p2 == NULL)
+  {
+    for (i = 0; i < length && n <= budget; i++)
+    { n += sequence1[start + i] != sequence2[i]; }
+    return n;
+  }
+  for (i = 0; i < length && n <= budget; i += 64)
+  {
+    diff = (shifted_word(p1->low, start + i) ^ p2->low[i / 64]) |
+           (shifted_word(p1->high, start + i) ^ p2->high[i / 64]) |
+           (shifted_word(p1->other, start + i) ^ p2->other[i / 64]);
+    if (length - i < 64) diff &= ((uint64_t)1 << (length - i)) - 1;
+    n += __builtin_popcountll(diff);
+  }
+  return n;
+}
+
+
+/*                                                                           */
+/* merge_pair()                                                              */
+/*                                                                           */
+/*   This function searches a pair of entries for the overlap, and appends   */
+/*   the merged entries, or the input entries unless they overlap, to a      */
+/*   text.  With option -i, only the headers of merged entries are appended. */
+/*   The longest overlap between the 3' end of read 1 and the 5' end of the  */
+/*   reverse complement of read 2 is taken, as long as it is min_overlap or  */
+/*   longer and has maximum_mismatches (option -M) or fewer mismatches.      */
+/*   At each position of the overlap, the base of the higher quality score   */
+/*   is taken with the score.                                                */
+/*   It returns 1 if either of the entries is broken, or else 0.             */
+/*                                                                           */
+int merge_pair(struct text *t, struct record *entry1, struct record *entry2,
+               int min_overlap)
 {
-  int i, j, k;	/* counter */
-  int len1, len2, lenp, lenfrag1;
-  char header1[MAX_CHAR];
-  char header2[MAX_CHAR];
+  int j, k;	/* counter */
+  int len1, len2, lenp, start;
+  short int first;	/* the base of read 1 is taken */
   char sequence1[MAX_CHAR];
   char sequence2[MAX_CHAR];
   char sequence3[MAX_CHAR];	/* for output */
-  char thirdline1[MAX_CHAR];
-  char thirdline2[MAX_CHAR];
   char qscores1[MAX_CHAR];
   char qscores2[MAX_CHAR];
   char qscores3[MAX_CHAR];	/* for output */
-  char probe[MAX_CHAR];
-  char *prb;	/* a pointer for the probe */
-  FILE *fastq1, *fastq2;
+  struct planes planes1, planes2;
+  struct planes *p1 = &planes1, *p2 = &planes2;
+
+  if (!copy_entry(entry1, sequence1, qscores1) ||
+      !copy_entry(entry2, sequence2, qscores2))
+  { return 1; }
+  len1 = entry1->length_sequence;
+  len2 = entry2->length_sequence;
+
+  uc_only_tcag(sequence1);
+  uc_only_tcag(sequence2);
+  complementary_sequence(sequence2);
+  reverse_sequence(qscores2);
+
+  if (len1 < min_overlap || len2 < min_overlap)
+  { print_input_fastq:
+    if (id == 0)
+    {
+      print_entry(t, entry1, sequence1, qscores1);
+      complementary_sequence(sequence2); reverse_sequence(qscores2);
+      print_entry(t, entry2, sequence2, qscores2);
+    }
+    return 0;
+  }
+
+  /* the longest overlap within the mismatch budget */
+  if (maximum_mismatches < 0 ||
+      !find_pieces(sequence1, len1, sequence2, min_overlap))
+  { goto print_input_fastq; }
+  if (!encode_planes(sequence1, len1, p1) ||
+      !encode_planes(sequence2, len2, p2))
+  { p1 = p2 = NULL; }
+  for (lenp = len1 < len2 ? len1 : len2; lenp >= min_overlap; lenp--)
+  {
+    start = len1 - lenp;
+    if (count_mismatches(p1, p2, sequence1, sequence2, start, lenp,
+                         maximum_mismatches) <= maximum_mismatches)
+    { break; }
+  }
+  if (lenp < min_overlap) goto print_input_fastq;
+  if (check_repeats(&sequence1[start], lenp) > 0) goto print_input_fastq;
+
+  for (j = 0; j < start; j++)
+  { sequence3[j] = sequence1[j]; qscores3[j] = qscores1[j]; }
+  for (k = 0; k < lenp; j++, k++)	/* k: for overlapped region */
+  {	/* a tie goes to read 1 if it is not longer than read 2 */
+    first = len1 <= len2 ? qscores1[j] >= qscores2[k] :
+                           qscores1[j] > qscores2[k];
+    sequence3[j] = first ? sequence1[j] : sequence2[k];
+    qscores3[j] = first ? qscores1[j] : qscores2[k];
+  }
+  for (; k < len2; j++, k++)
+  {
+    sequence3[j] = sequence2[k];
+    qscores3[j] = qscores2[k];
+  }
+  sequence3[j] = qscores3[j] = '\0';
+
+  /* output two entries (identical, but complementary) */
+  if (id == 0)
+  {
+    print_entry(t, entry1, sequence3, qscores3);
+    complementary_sequence(sequence3); reverse_sequence(qscores3);
+    print_entry(t, entry2, sequence3, qscores3);
+  }
+  else
+  {
+    print_ids(t, entry1, entry2);
+  }
+  return 0;
+}
+
+
+void *merge_part(void *arg)
+{
+  struct part *s = (struct part *)arg;
+  int i;
+
+  s->text.size = 0;
+  s->broken = -1;
+  for (i = s->first; i < s->last; i++)
+  {
+    if (merge_pair(&s->text, s->records1 + i, s->records2 + i,
+                   s->min_overlap))
+    { s->broken = i; break; }
+  }
+  return NULL;
+}
+
+
+/*                                                                           */
+/* merge_batch()                                                             */
+/*                                                                           */
+/*   This function divides n pairs of entries into n_threads parts, merges   */
+/*   them at the same time, and writes the texts in order.  It returns the   */
+/*   position of a broken pair after the pairs before it are written, or     */
+/*   -1 when no pair is broken.                                              */
+/*                                                                           */
+int merge_batch(struct bgzf_output *o, struct record *records1,
+                struct record *records2, int n, int min_overlap)
+{
+  pthread_t threads[MAX_THREADS];
+  int size = (n + n_threads - 1) / n_threads;
+  int t;
+
+  for (t = 0; t < n_threads; t++)
+  {
+    merge_parts[t].records1 = records1;
+    merge_parts[t].records2 = records2;
+    merge_parts[t].first = t * size < n ? t * size : n;
+    merge_parts[t].last = (t + 1) * size < n ? (t + 1) * size : n;
+    merge_parts[t].min_overlap = min_overlap;
+  }
+  for (t = 1; t < n_threads; t++)
+  {
+    if (pthread_create(&threads[t], NULL, merge_part, &merge_parts[t]))
+    { ERROR_MESSAGE(227, "thread creation"); }
+  }
+  merge_part(&merge_parts[0]);
+  for (t = 1; t < n_threads; t++) pthread_join(threads[t], NULL);
+
+  for (t = 0; t < n_threads; t++)
+  {
+    write_output(o, merge_parts[t].text.data, merge_parts[t].text.size);
+    if (merge_parts[t].broken >= 0) return merge_parts[t].broken;
+  }
+  return -1;
+}
+
+
+/*                                                                           */
+/* merge_fastq()                                                             */
+/*                                                                           */
+/*   This function is called by main() when another file name is provided    */
+/*   with option -g.                                                         */
+/*   Pairs of entries are taken in batches and merged in n_threads threads.  */
+/*   When the second file gives fewer entries than the first, the rest of    */
+/*   the first is read again in the next batch.                              */
+/*   The output FASTQ is printed onto the standard output.                   */
+/*                                                                           */
+int merge_fastq(char *name_fastq_r1, char *name_fastq_r2, int min_overlap)
+{
+  static struct record records1[SIZE_BATCH], records2[SIZE_BATCH];
+  char headers[2 * MAX_CHAR];	/* for an error message */
+  struct record_reader *fastq1, *fastq2;
+  struct bgzf_output *output;
+  int i, t, n1, n2;
 
   /**** open the two FASTQ files ****/
-  if ((fastq1 = fopen(name_fastq_r1, "r")) == NULL)
+  if ((fastq1 = open_records(name_fastq_r1, n_threads)) == NULL)
   { ERROR_MESSAGE(218, name_fastq_r1); }
-  if ((fastq2 = fopen(name_fastq_r2, "r")) == NULL)
+  if ((fastq2 = open_records(name_fastq_r2, n_threads)) == NULL)
   { ERROR_MESSAGE(219, name_fastq_r2); }
+  output = open_output(stdout, compress_output, n_threads);
 
-  /**** read line by line ****/
-  while (fgets(header1, MAX_CHAR, fastq1) != NULL)
+  /**** read entries batch by batch ****/
+  while ((n1 = next_records(fastq1, records1, SIZE_BATCH)) > 0)
   {
-    if (fgets(header2, MAX_CHAR, fastq2) == NULL)
+    if ((n2 = next_records(fastq2, records2, n1)) == 0)
     {
+      close_output(output);
+      if (fastq2->error > 0) { ERROR_MESSAGE(221, name_fastq_r2); }
       fprintf(stderr, "Unexpected file end: %s\n", name_fastq_r2);
-      fclose(fastq1); fclose(fastq2);
+      close_records(fastq1); close_records(fastq2);
       exit(220);
     }
-    if (header1[0] == '@' && header2[0] == '@')
-    {
-      if (fgets(sequence1, MAX_CHAR, fastq1) == NULL) goto exit221;
-      if (fgets(sequence2, MAX_CHAR, fastq2) == NULL) goto exit221;
-      len1 = strlen(sequence1);
-      len2 = strlen(sequence2);
-      sequence1[len1 - 1] = '\0';	/* replace the new line with '\0'*/
-      sequence2[len2 - 1] = '\0';
-      if (fgets(thirdline1, MAX_CHAR, fastq1) == NULL) goto exit221;
-      if (fgets(thirdline2, MAX_CHAR, fastq2) == NULL) goto exit221;
-      if (fgets(qscores1, MAX_CHAR, fastq1) == NULL) goto exit221;
-      if (fgets(qscores2, MAX_CHAR, fastq2) == NULL) goto exit221;
-      qscores1[len1 - 1] = '\0';	/* lengths of sequence and qscores */
-      qscores2[len2 - 1] = '\0';	/* should be identical */
-      len1--; len2--;	/* remove the new line */
-    }
-    else
-    { exit221:
-      fclose(fastq1); fclose(fastq2);
-      { ERROR_MESSAGE(221, strcat(header1, header2)); }
-    }
-
-    uc_only_tcag(sequence1);
-    uc_only_tcag(sequence2);
-    complementary_sequence(sequence2);
-    reverse_sequence(qscores2);
-
-    if (len1 < min_overlap || len2 < min_overlap)
-    { print_input_fastq:
-      if (id == 0)
-      {
-        fprintf(stdout, "%s%s\n%s%s\n",
-                        header1, sequence1, thirdline1, qscores1);
-        complementary_sequence(sequence2); reverse_sequence(qscores2);
-        fprintf(stdout, "%s%s\n%s%s\n",
-                        header2, sequence2, thirdline2, qscores2);
-      }
-      next_entry: continue;
-    }
+    if (n2 < n1) seek_records(fastq1, records1[n2].offset);
 
-    if (len1 <= len2)
-    {	/* probe: its length is min_overlap */
-      strcpy(probe, &sequence1[len1 - min_overlap]);
-      if (strstr(sequence2, probe) == NULL) goto print_input_fastq;
-      strcpy(probe, sequence1);
-      prb = probe;
-      lenp = strlen(prb);
-      i = 0;
-      while (lenp >= min_overlap)
-      {
-        if (strncmp(prb, sequence2, lenp) == 0)	/* perfect match */
-        {
-          if (check_repeats(prb, lenp) > 0) goto print_input_fastq;
-          for (j = 0; j < i; j++)
-          { sequence3[j] = sequence1[j]; qscores3[j] = qscores1[j]; }
-          lenfrag1 = j;	/* length of the most 5' fragment */
-          for (k = 0; k < lenp; j++, k++)	/* k: for overlapped region */
-          {
-            sequence3[j] = sequence2[k];
-            if (qscores1[lenfrag1 + k] >= qscores2[k])
-            { qscores3[j] = qscores1[lenfrag1 + k]; }
-            else
-            { qscores3[j] = qscores2[k]; }
-          }
-          for (; k < len2; j++, k++)
-          {
-            sequence3[j] = sequence2[k];
-            qscores3[j] = qscores2[k];
-          }
-          sequence3[j] = qscores3[j] = '\0';
-
-          /* output two entries (identical, but complementary) */
-          if (id == 0)
-          {
-            fprintf(stdout, "%s%s\n%s%s\n",
-                            header1, sequence3, thirdline1, qscores3);
-            complementary_sequence(sequence3); reverse_sequence(qscores3);
-            fprintf(stdout, "%s%s\n%s%s\n",
-                            header2, sequence3, thirdline2, qscores3);
-          }
-          else { fprintf(stdout, "%s%s", header1, header2); }
-          goto next_entry;
-        }
-        lenp = strlen(++prb);
-        i++;	/* does not match and 1-bp slide */
-      }
-    }
-    else
+    if ((i = merge_batch(output, records1, records2, n2, min_overlap)) >= 0)
     {
-      for (j = 0; j < (len1 - len2); j++)
-      { sequence3[j] = sequence1[j]; qscores3[j] = qscores1[j]; }
-
-      strncpy(probe, sequence2, min_overlap);
-      probe[min_overlap] = '\0';
-      if (strstr(sequence1, probe) == NULL) goto print_input_fastq;
-      lenp = len2;	/* sequence2 is used as probe */
-      while (lenp >= min_overlap)
-      {
-        if (strncmp(&sequence1[j], sequence2, lenp) == 0)
-        {	/* perfect match */
-          if (check_repeats(&sequence1[j], lenp) > 0) goto print_input_fastq;
-          for (k = 0; sequence2[k] != '\0'; j++, k++)
-          {
-            sequence3[j] = sequence2[k];
-            if (k < lenp && qscores1[j] > qscores2[k])
-                 { qscores3[j] = qscores1[j]; }
-            else { qscores3[j] = qscores2[k]; }
-          }
-          sequence3[j] = qscores3[j] = '\0';
-
-          /* output two entries (identical, but complementary) */
-          if (id == 0)
-          {
-            fprintf(stdout, "%s%s\n%s%s\n",
-                        header1, sequence3, thirdline1, qscores3);
-            complementary_sequence(sequence3); reverse_sequence(qscores3);
-            fprintf(stdout, "%s%s\n%s%s\n",
-                        header2, sequence3, thirdline2, qscores3);
-          }
-          else { fprintf(stdout, "%s%s", header1, header2); }
-          goto next_entry;
-        }
-        sequence3[j] = sequence1[j]; qscores3[j] = qscores1[j];
-        j++; lenp--;	/* does not match and 1-bp slide */
-      }
+      sprintf(headers, "%.*s\n%.*s\n",
+              records1[i].length_header < MAX_CHAR ?
+              records1[i].length_header : 0, records1[i].header,
+              records2[i].length_header < MAX_CHAR ?
+              records2[i].length_header : 0, records2[i].header);
+      close_output(output);
+      close_records(fastq1); close_records(fastq2);
+      { ERROR_MESSAGE(221, headers); }
     }
-    /* unless match, it comes here */
-    goto print_input_fastq;
   }
 
-  fclose(fastq1); fclose(fastq2);
+  if (fastq1->error > 0) { ERROR_MESSAGE(221, name_fastq_r1); }
+  close_output(output);
+  close_records(fastq1); close_records(fastq2);
+  for (t = 0; t < n_threads; t++) free(merge_parts[t].text.data);
   return EXIT_SUCCESS;
 }
@@ -4,6 +4,8 @@
 /*                                                                           */
 /* DESCRIPTION                                                               */
 /*   This module is responsible for only printing DNA sequences.             */
+/*   Sequences are printed onto the output stream of each walker, which is   */
+/*   the standard output unless two or more seeds are walked at once.        */
 /*                                                                           */
 /* AUTHOR                                                                    */
 /*   Coded by Kohji OKAMURA, Ph.D.                                           */
@@ -13,6 +15,12 @@
 /*   Oct 01, 2014  Expand the size of seq_buffer[]; support option -o        */
 /*   Dec 02, 2014  Not print the code of N any longer                        */
 /*   May 17, 2015  Minor changes                                             */
+/*   Oct 17, 2026  Each walker has its own seq_buffer and output stream      */
+/*   Oct 17, 2026  Keep the bases of a paired walker in memory (option -B)   */
+/*   Oct 17, 2026  Take n_columns from the context of the walker             */
+/*   Oct 17, 2026  Print the bases kept at the end of the walk (option -C)   */
+/*   Oct 17, 2026  Keep the bases for the checkpoint file (option -F)        */
+/*   Oct 17, 2026  Keep the bases kept so far if they cannot be enlarged     */
 /*                                                                           */
 
 
@@ -20,12 +28,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include "defaults.h"
-
-
-extern int n_columns;
-	/* default: 50; can change the number of bases in a line (option -o) */
-
-char seq_buffer[MAX_CHAR] = "";
+#include "grepwalk.h"
+#include "examine_reads.h"
 
 
 /*                                                                           */
@@ -33,19 +37,70 @@ char seq_buffer[MAX_CHAR] = "";
 /*                                                                           */
 /*   This function is only called internally from print_bases().             */
 /*                                                                           */
-void print_bases_forcefully(char *extending)
+void print_bases_forcefully(struct walker *w, char *extending)
 {
   unsigned short int i, l;
+  int n_columns = w->gw->n_columns;	/* bases in a line (option -o) */
+  char *seq_buffer = w->seq_buffer;
 
   while ((l = (unsigned short int)strlen(seq_buffer)) >= n_columns)
   {
-    for (i = 0; i < n_columns; i++) fputc(*(extending + i), stdout);
-    fputc('\n', stdout);
+    for (i = 0; i < n_columns; i++) fputc(*(extending + i), w->output);
+    fputc('\n', w->output);
     for (; i <= l; i++) { seq_buffer[i - n_columns] = seq_buffer[i]; }
 	/* lastly, the null character is also copied */
   }
   if ((l = (unsigned short int)strlen(seq_buffer)) > 0)
-  { fprintf(stdout, "%s\n", seq_buffer); seq_buffer[0] = '\0'; }
+  { fprintf(w->output, "%s\n", seq_buffer); seq_buffer[0] = '\0'; }
+}
+
+
+/*                                                                           */
+/* keep_bases()                                                              */
+/*                                                                           */
+/*   This function is only called internally from print_bases().             */
+/*   The bases printed are also kept in memory for a walker of option -B,    */
+/*   so that they are stitched with those of its mate at the end, and for    */
+/*   one of option -C, so that they are cut where a circle is closed, and    */
+/*   for the checkpoint file of option -F.                                   */
+/*                                                                           */
+void keep_bases(struct walker *w, char *extending)
+{
+  long int l = (long int)strlen(extending);
+  char *contig;
+
+  if (w->length_contig + l >= w->size_contig)
+  {
+    contig = (char *)realloc(w->contig, 2 * (w->length_contig + l + MAX_CHAR));
+    if (contig == NULL)
+    { ERROR_MESSAGE(226, "memory allocation for a stitched sequence"); }
+    w->contig = contig;
+    w->size_contig = 2 * (w->length_contig + l + MAX_CHAR);
+  }
+  memcpy(w->contig + w->length_contig, extending, l + 1);
+  w->length_contig += l;
+}
+
+
+/*                                                                           */
+/* print_contig()                                                            */
+/*                                                                           */
+/*   This function prints the bases kept by a walker of option -C with its   */
+/*   FASTA header, which tells whether the sequence is circular.             */
+/*                                                                           */
+void print_contig(struct walker *w, int circular)
+{
+  int n_columns = w->gw->n_columns;	/* bases in a line (option -o) */
+  long int i, l;
+
+  fprintf(w->output, circular ? ">%s [topology=circular]\n" : ">%s\n",
+          w->name);
+  for (i = 0; i < w->length_contig; i += l)
+  {
+    l = w->length_contig - i < n_columns ? w->length_contig - i : n_columns;
+    fwrite(w->contig + i, 1, l, w->output);
+    fputc('\n', w->output);
+  }
 }
 
 
@@ -58,9 +113,11 @@ void print_bases_forcefully(char *extending)
 /*   when it succeeds.                                                       */
 /*   It returns a code, 1, 2, 3, etc. when a code of N is received.          */
 /*                                                                           */
-int print_bases(char *extending)
+int print_bases(struct walker *w, char *extending)
 {
   unsigned short int i, l;
+  int n_columns = w->gw->n_columns;	/* bases in a line (option -o) */
+  char *seq_buffer = w->seq_buffer;
 
   if (strcmp(extending, "N") == 0 ||
       strcmp(extending, "NN") == 0 ||
@@ -69,15 +126,22 @@ int print_bases(char *extending)
       strcmp(extending, "NNNNN") == 0 ||
       strcmp(extending, "NNNNNN") == 0 )
   {
-    print_bases_forcefully(extending);
+    print_bases_forcefully(w, extending);
     return (int)strlen(extending);	/* return the code */
   }
-  else { strcat(seq_buffer, extending); }
+  else
+  {
+    if (w->mate >= 0 || w->gw->circular || w->gw->checkpoint[0] != '\0')
+    { keep_bases(w, extending); }
+    if (w->mate < 0 && w->gw->circular) return EXIT_SUCCESS;
+	/* printed by print_contig() when the walk is finished */
+    strcat(seq_buffer, extending);
+  }
 
   while ((l = (unsigned short int)strlen(seq_buffer)) >= n_columns)
   {
-    for (i = 0; i < n_columns; i++) fputc(*(seq_buffer + i), stdout);
-    fputc('\n', stdout);
+    for (i = 0; i < n_columns; i++) fputc(*(seq_buffer + i), w->output);
+    fputc('\n', w->output);
     for (; i <= l; i++) { seq_buffer[i - n_columns] = seq_buffer[i]; }
 	/* lastly, the null character is also copied */
   }
@@ -24,6 +24,23 @@
 /*   Mar 22, 2015  Support option -r                                         */
 /*   Apr 22, 2015  Change return values                                      */
 /*   Aug 05, 2017  Support option -p                                         */
+/*   Oct 17, 2026  Support option -k                                         */
+/*   Oct 17, 2026  Support option -a                                         */
+/*   Oct 17, 2026  Support option -j                                         */
+/*   Oct 17, 2026  Support option -S                                         */
+/*   Oct 17, 2026  Exit status 2 is not used; the nominee table grows        */
+/*   Oct 17, 2026  Support option -K                                         */
+/*   Oct 17, 2026  Support option -z and gzip input                          */
+/*   Oct 17, 2026  Support option -Q                                         */
+/*   Oct 17, 2026  Support option -M                                         */
+/*   Oct 17, 2026  Support option -P                                         */
+/*   Oct 17, 2026  Support option -B                                         */
+/*   Oct 17, 2026  Support option -T                                         */
+/*   Oct 17, 2026  Support option -D                                         */
+/*   Oct 17, 2026  Support option -C                                         */
+/*   Oct 17, 2026  Support options -F and -R                                 */
+/*   Oct 17, 2026  Support option -E                                         */
+/*   Oct 17, 2026  Say that option -D is for linear walks                    */
 /*                                                                           */
 
 
@@ -40,9 +57,11 @@ int print_usage(void)
     "\n");
   fprintf(stderr, "%s",
     "SYNOPSIS\n"
-    "    grepwalk [-c] [-d num] [-f file] [-g file] [-h] [-i] [-l num]\n"
-    "             [-m num] [-n name] [-o num] [p] [-q num] [-s sequence]\n"
-    "             [-t] [-u] [-v] [-w num] [-x num]\n"
+    "    grepwalk [-a] [-B] [-c] [-C] [-D] [-d num] [-E] [-f file]\n"
+    "             [-F file] [-g file] [-h] [-i] [-j num] [-k file] [-K]\n"
+    "             [-l num] [-m num] [-M num] [-n name] [-o num] [p] [-P]\n"
+    "             [-q num] [-Q] [-R] [-s sequence] [-S file] [-t]\n"
+    "             [-T file] [-u] [-v] [-w num] [-x num] [-z]\n"
     "\n");
   fprintf(stderr, "%s",
     "DESCRIPTION\n"
@@ -61,26 +80,51 @@ int print_usage(void)
     "\n");
   fprintf(stderr, "%s%d%s",
     "OPTIONS\n"
+    "    -a  Keep all reads in memory during the extension\n"
+    "          The input file can be the standard input (-f -).\n"
+    "    -B  Extend both directions at once and print one sequence\n"
+    "          The walk stops when the two ends meet on a circular genome.\n"
     "    -c  Extend the opposite direction or complementary strand\n"
     "          default: none\n"
+    "    -C  Stop a walk when it goes around a circular genome\n"
+    "          One circle is printed, and the header says it is circular.\n"
+    "    -D  Drop reads the walk has passed, and those of low quality\n"
+    "          Later passes read only the reads left; see -T for how many.\n"
+    "          For linear walks; a circular genome stops near the seed\n"
+    "          instead of at -x, so use -C without -D for it.\n"
     "    -d  Strand depth of coverage\n"
     "          default: ", DEFAULT_STRAND_DEPTH, "\n"
     "    -e  Print the last contents in the nominee table onto the stderr\n"
-    "          default: none\n");
+    "          default: none\n"
+    "    -E  Extend the walk of -F on reads appended to the input file\n"
+    "          Ends that stopped for lack of depth walk again.\n");
   fprintf(stderr, "%s",
     "    -f  Specify the name of the input file (FASTQ or FASTA)\n"
     "          In many cases, this option is mandatory.\n"
+    "          The file may be compressed with gzip or bgzip; a walk on it\n"
+    "          is faster with -a.\n"
+    "    -F  Name of a checkpoint file written after each pass of a walk\n"
+    "          The last one is written when the walk is over; see -R, -E.\n"
     "    -g  Name of another FASTQ file to be merged\n"
     "          This is for a pre-process of paired-end reads.\n");
-  fprintf(stderr, "%s%d%s%d%s",
+  fprintf(stderr, "%s%d%s%d%s%d%s%d%s",
     "    -h  Print help\n"
     "          This is the help message printed by this option.\n"
     "    -i  Print only header lines whose paired reads are overlapping\n"
     "          This option should be used with option -g.\n"
+    "    -j  Number of threads to search, count, trim, or merge reads\n"
+    "          default: ", DEFAULT_THREADS, "\n"
+    "    -k  Name of the k-mer index file of the input file\n"
+    "          The index is built and saved unless the file exists.\n"
+    "          Reads appended to the input file are added to the index.\n"
+    "    -K  Keep walking when the last struggle extends the sequence\n"
+    "          Otherwise the walk stops after the struggle.\n"
     "    -l  Slideing size (bp) of the window analysis\n"
     "          default: ", DEFAULT_SLIDE, "\n"
     "    -m  Minimum overlapping length used with option -g\n"
     "          default: ", DEFAULT_MIN_OVERLAP, "\n"
+    "    -M  Maximum number of mismatches in the overlap with option -g\n"
+    "          default: ", DEFAULT_MISMATCHES, "\n"
     "    -n  Name the output sequence\n"
     "          This is the name that appears in the FASTA header.\n");
   fprintf(stderr, "%s%d%s%d%s%s%s",
@@ -88,14 +132,24 @@ int print_usage(void)
     "          default: ", DEFAULT_N_COLUMNS, "\n"
     "    -p  Remove needless characters in FASTQ if provided with -t\n"
     "          default: none\n"
+    "    -P  Trim the files of -f and -g, merge them, and walk in memory\n"
+    "          No intermediate files are written; -a is implied.\n"
     "    -q  Minimal quality score\n"
     "          default: ", DEFAULT_MIN_QSCORE, "\n"
+    "    -Q  Report qualities by cycle, read lengths, and G+C with -u\n"
+    "          Tables follow the numbers of reads and bases.\n"
     "    -r  Ignore directions of reads to count strand depth\n"
     "          default: none\n"
+    "    -R  Resume a walk from the checkpoint file of -F if it exists\n"
+    "          Seeds, options, and reads should be the same; not with -D.\n"
     "    -s  Initial seed sequence\n"
     "          default: ", DEFAULT_SEED, "\n"
+    "    -S  Name of a file of seeds to be extended at the same time\n"
+    "          One seed in a line, which may follow a line of '>name'.\n"
     "    -t  Trim low quality bases in a FASTQ\n"
-    "          This option can be used with -q.\n");
+    "          This option can be used with -q.\n"
+    "    -T  Name of a file of a tab-separated row for each extension\n"
+    "          The time of each phase and the peak memory follow.\n");
   fprintf(stderr, "%s%s%s%d%s%d%s",
     "    -u  Count numbers of reads and bases in a FASTQ\n"
     "          default: none\n"
@@ -105,12 +159,13 @@ int print_usage(void)
     "          default: ", DEFAULT_WINDOW, "\n"
     "    -x  Maximal length in bp, when reached, programme stops\n"
     "          default: ", DEFAULT_MAX_LENGTH, "\n"
+    "    -z  Compress the output of -t or -g into BGZF\n"
+    "          Blocks are compressed in the threads given with -j.\n"
     "\n");
   fprintf(stderr, "%s",
     "EXIT STATUS\n"
     "    0      Exceeding the maximum length\n"
     "    1      Number of reads or bases may be insufficient\n"
-    "    2      Overflow of the nominee table (seed may be too short)\n"
     "    > 200  Advanced or developer-only code numbers\n"
     "\n");
   fprintf(stderr, "%s",
@@ -119,9 +174,24 @@ int print_usage(void)
     "    grepwalk -t -f paired_1.fastq > paired_t_1.fastq\n"
     "    grepwalk -t -f paired_2.fastq > paired_t_2.fastq\n"
     "    grepwalk -g paired_t_2.fastq -f paired_t_1.fastq > paired_m.fastq\n"
+    "    grepwalk -M 2 -j 4 -g paired_2.fastq -f paired_1.fastq > m.fastq\n"
     "    grepwalk -f paired_m.fastq\n"
+    "    grepwalk -P -g paired_2.fastq -f paired_1.fastq\n"
     "    grepwalk -w 40 -l 20 -d 8 -f paired_m.fastq\n"
+    "    grepwalk -k paired_m.gwi -f paired_m.fastq\n"
+    "    grepwalk -j 8 -a -f paired_m.fastq\n"
+    "    grepwalk -S seeds.txt -f paired_m.fastq\n"
+    "    grepwalk -B -a -f paired_m.fastq\n"
+    "    grepwalk -D -a -f paired_m.fastq\n"
+    "    grepwalk -C -a -f paired_m.fastq\n"
+    "    grepwalk -F walk.ckp -R -a -f paired_m.fastq\n"
+    "    cat lane2_m.fastq >> paired_m.fastq\n"
+    "    grepwalk -F walk.ckp -E -k paired_m.gwi -f paired_m.fastq\n"
+    "    grepwalk -T walk.tsv -f paired_m.fastq\n"
+    "    zcat paired_m.fastq.gz | grepwalk -a -f -\n"
+    "    grepwalk -z -j 4 -t -f paired_1.fastq.gz > paired_t_1.fastq.gz\n"
     "    grepwalk -u -q 20 -f paired_1.fastq\n"
+    "    grepwalk -u -Q -j 4 -f paired_1.fastq.gz > paired_1.qc.txt\n"
     "\n");
   fprintf(stderr, "%s",
     "AUTHOR\n"
@@ -153,4 +223,13 @@ int print_usage(void)
 /*   221  Error: merge                                 */
 /*   222  Error: input FASTQ file (-f) in read_reads() */
 /*   223  Error: format                                */
+/*   224  Error: writing the k-mer index (-k)          */
+/*   225  Error: reading the k-mer index (-k)          */
+/*   226  Error: memory allocation                     */
+/*   227  Error: threads (-j)                          */
+/*   228  Error: file of seeds (-S)                    */
+/*   229  Error: temporary file                        */
+/*   230  Error: gzip or BGZF file                     */
+/*   231  Error: file of the rows of extensions (-T)   */
+/*   232  Error: checkpoint (-F) or options together   */
 /*                                                     */
@@ -3,7 +3,7 @@
 /*   read_reads.c - read reads provided in a fastq or fasta file             */
 /*                                                                           */
 /* DESCRIPTION                                                               */
-/*   This module is called from the main module of GrepWalk.                 */
+/*   This module is called from libgrepwalk.c.                               */
 /*   This module calls the examine_reads modele.                             */
 /*                                                                           */
 /* AUTHOR                                                                    */
@@ -25,175 +25,579 @@
 /*   Dec 02, 2014  Ver. 0.6; set exit status, print the nominee table        */
 /*   Dec 05, 2014  Avoid warning on ignoring return value of fgets()         */
 /*   Jun 05, 2015  Change return values of read_reads() to EXIT_SUCCESS      */
+/*   Oct 17, 2026  Split read_record() and examine_sequence(); option -k     */
+/*   Oct 17, 2026  Support option -a to walk on reads kept in memory         */
+/*   Oct 17, 2026  Support option -j to search reads for the seed in threads */
+/*   Oct 17, 2026  Walk from two or more seeds at once (option -S)           */
+/*   Oct 17, 2026  Find the seed on both strands in one scan of a read       */
+/*   Oct 17, 2026  Support option -K to keep walking after a struggle        */
+/*   Oct 17, 2026  Read entries with record_reader.c                         */
+/*   Oct 17, 2026  Walk on reads trimmed and merged in memory (option -P)    */
+/*   Oct 17, 2026  Walk both ways and stitch the two sequences (option -B)   */
+/*   Oct 17, 2026  Count passes, reads, and bytes; time phases (option -T)   */
+/*   Oct 17, 2026  Walk on struct grepwalk instead of global variables       */
+/*   Oct 17, 2026  Drop reads the walk has passed from later passes (-D)     */
+/*   Oct 17, 2026  Check the quality window in runs; skip unusable reads     */
+/*   Oct 17, 2026  Move uc_only_tcag() and the others to base_kernels.c      */
+/*   Oct 17, 2026  Stop a walk that goes around a circular genome (-C)       */
+/*   Oct 17, 2026  Write a checkpoint after each pass; resume it (-F, -R)    */
+/*   Oct 17, 2026  Extend a walk on reads appended to the file (option -E)   */
+/*   Oct 17, 2026  Reject a pipe to walk on unless reads are kept (-a, -D)   */
+/*   Oct 17, 2026  Unpack a stored read only when it holds a seed (-a)       */
 /*                                                                           */
 
 
-#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "defaults.h"
+#include "grepwalk.h"
+#include "examine_reads.h"
+#include "record_reader.h"
 
-#define MAX_CHAR 0x400
 #define MAX_LENGTH 131072L
 #define HIGH_QSCORE 'H'
 
-char ns[] = "NNNNNNN";
 
-extern char *initial_seed;
-extern char seed[];		/* "extern char *seed;" does not work */
-extern char name[];
-extern int slide;
-extern int length_initial_seed;
-extern long int maximum_length;
-extern short int nominee;
+void uc_only_tcag(char *);
+int complementary_sequence(char *);
+int check_read(struct walker *, char *, int);
+void quality_runs(struct grepwalk *, char *, struct quality_runs *);
+int window_passes(struct grepwalk *, struct quality_runs *, int, short int);
+int usable_read(struct read_store *, long int);
+int lastly_struggle(struct walker *);
+void init_extending_seq_table(struct walker *);
+int print_bases(struct walker *, char *);
+void print_contig(struct walker *, int);
+int print_nominee_table(struct walker *);
+long int next_indexed_read(struct kmer_index *, char *, long int);
+long int indexed_read_offset(struct kmer_index *, long int);
+int fetch_stored_read(struct read_store *, long int, char *, char *);
+int scan_reads(struct grepwalk *);
+struct record_reader *open_records(char *, int);
+int next_records(struct record_reader *, struct record *, int);
+void seek_records(struct record_reader *, long int);
+int seekable_records(struct record_reader *);
+void close_records(struct record_reader *);
+void build_seed_matcher(struct walker *);
+int find_seed(struct walker *, char *, int *);
+int find_stored_seed(struct walker *, struct read_store *, long int, int *);
+void finish_walker(struct walker *, int);
+void switch_phase(struct walk_stats *, int);
+void close_walk_stats(struct walk_stats *);
+void open_working_set(struct grepwalk *);
+void pass_working_set(struct grepwalk *);
+int next_live_read(struct grepwalk *, long int *, char *, char *);
+int drop_read(struct grepwalk *, long int, char *);
+void hold_read(struct walker *, long int, int);
+int close_circle(struct walker *);
+int load_checkpoint(struct grepwalk *, char *);
+void replay_walker(struct walker *);
+int write_checkpoint(struct grepwalk *, char *);
 
-long int length_assembled = 0;
-short int strand = 0;		/* 1: plus strand; 2: minus strand */
-short int loop_counter = 0;
 
+/*                                                                           */
+/* read_record()                                                             */
+/*                                                                           */
+/*   This function reads one entry of a fastq or fasta file.                 */
+/*   It returns 1 when an entry is read, or 0 at the end of the file.        */
+/*   Quality scores of a fasta entry are filled with HIGH_QSCORE.            */
+/*                                                                           */
+int read_record(struct record_reader *fastq, char *sequence, char *qscores)
+{
+  int i;
+  struct record r;
 
-int check_read(char *, char *);
-int lastly_struggle(void);
-void init_extending_seq_table(void);
-int print_bases(char *);
-int print_nominee_table(void);
+  if (next_records(fastq, &r, 1) == 0)
+  {
+    if (fastq->error == 0) return 0;
+    fail_walk(223, "File format error: broken entry at the end");
+  }
+  if ((r.header[0] != '@' && r.header[0] != '>') ||
+      r.length_sequence >= MAX_CHAR || r.length_qscores >= MAX_CHAR)
+  {
+    fail_walk(223, "File format error: %.*s",
+              r.length_header < MAX_CHAR ? r.length_header : MAX_CHAR,
+              r.header);
+  }
+  memcpy(sequence, r.sequence, r.length_sequence);
+  sequence[r.length_sequence] = '\0';
+  if (r.qscores != NULL)
+  {
+    memcpy(qscores, r.qscores, r.length_qscores);
+    qscores[r.length_qscores] = '\0';
+  }
+  else
+  {
+    for (i = 0; i < r.length_sequence; i++) { qscores[i] = HIGH_QSCORE; }
+    qscores[i] = '\0';
+  }
+  return 1;
+}
 
 
 /*                                                                           */
-/* uc_only_tcag()                                                            */
+/* add_walker()                                                              */
 /*                                                                           */
-/*   This function changes t, c, a, and g to T, C, A, and G, respectively,   */
-/*   in a DNA sequence.                                                      */
+/*   This function is called from add_seed() for each seed to be walked.     */
 /*                                                                           */
-void uc_only_tcag(char *seq)
+struct walker *add_walker(struct grepwalk *gw, char *name, char *seed)
 {
-  int i;
+  struct walker *w;
 
-  for (i = 0; seq[i] != '\0'; i++)
-  {
-    if (seq[i] == 't' || seq[i] == 'c' || seq[i] == 'a' || seq[i] == 'g')
-    { seq[i] = toupper(seq[i]); }
+  w = (struct walker *)realloc(gw->walkers,
+                               (gw->n_walkers + 1) * sizeof(struct walker));
+  if (w == NULL) { ERROR_MESSAGE(226, "memory allocation for seeds"); }
+  gw->walkers = w;
+  w = gw->walkers + gw->n_walkers++;
+  w->gw = gw;
+  strcpy(w->name, name);
+  strcpy(w->seed, seed);
+  build_seed_matcher(w);
+  w->length_assembled = (long int)strlen(seed);
+  w->strand = 0;
+  w->loop_counter = 0;
+  w->active = 1;
+  w->finished = w->starved = 0;
+  w->seq_buffer[0] = '\0';
+  w->output = gw->output;
+  w->table = NULL;
+  w->mate = -1;
+  w->length_seed = (int)strlen(seed);
+  w->met = -1;
+  w->contig = NULL;
+  w->length_contig = w->size_contig = w->length_checked = 0;
+  w->hits_plus = w->hits_minus = w->rejected = 0;
+  w->held = NULL;
+  w->n_held = w->size_held = 0;
+  w->kmers = NULL;
+  w->bits_kmers = 0;
+  w->n_kmers = 0;
+  init_extending_seq_table(w);
+  return w;
+}
+
+
+/*                                                                           */
+/* pair_walkers()                                                            */
+/*                                                                           */
+/*   This function adds a mate for each seed of option -B.  The mate walks   */
+/*   from the reverse complement of the seed, i.e. in the opposite           */
+/*   direction, in the same passes over the reads.                           */
+/*                                                                           */
+void pair_walkers(struct grepwalk *gw)
+{
+  int i, n = gw->n_walkers;
+  char name[MAX_CHAR], seed[MAX_CHAR];
+
+  for (i = 0; i < n; i++)
+  {	/* copied, as add_walker() may move the walkers */
+    strcpy(name, gw->walkers[i].name);
+    strcpy(seed, gw->walkers[i].seed);
+    complementary_sequence(seed);
+    add_walker(gw, name, seed);
+    gw->walkers[i].mate = gw->n_walkers - 1;
+    gw->walkers[gw->n_walkers - 1].mate = i;
   }
 }
 
 
-int reverse_sequence(char *seq)
+/*                                                                           */
+/* meet_mate()                                                               */
+/*                                                                           */
+/*   This function searches the bases newly added by a walker of option -B   */
+/*   for the reverse complement of the seed of its mate.  If it is found,    */
+/*   the two ends have met on a circular genome, and both walks are          */
+/*   finished with code 2.  It returns 1 in that case, otherwise 0.          */
+/*                                                                           */
+int meet_mate(struct walker *w)
 {
-  int length = strlen(seq);
-  int i, j;
-  char base;
+  struct walker *m;
+  long int from;
+  char *found;
 
-  for (i = 0, j = length - 1; i < j; i++, j--)
-  { base = seq[i]; seq[i] = seq[j]; seq[j] = base; }
-  return length;
+  if (w->mate < 0 || !w->active) return 0;
+  m = w->gw->walkers + w->mate;
+  if (!m->active || w->length_checked == w->length_contig) return 0;
+  from = w->length_checked - (long int)strlen(m->seed) + 1;
+  if (from < 1) from = 1;	/* not the initial seed itself */
+  w->length_checked = w->length_contig;
+  if ((found = strstr(w->contig + from, m->matcher.seed_minus)) == NULL)
+  { return 0; }
+  w->met = (long int)(found - w->contig);
+  finish_walker(w, 2);
+  finish_walker(m, 2);
+  return 1;
 }
 
 
-int complementary_sequence(char *seq)
+/*                                                                           */
+/* print_stitched()                                                          */
+/*                                                                           */
+/*   This function prints the sequences of a walker of option -B and its     */
+/*   mate as one sequence, i.e. the reverse complement of the mate's         */
+/*   followed by the walker's without the initial seed.  If the two ends     */
+/*   have met, the sequence is cut so that it goes once around the circle.   */
+/*                                                                           */
+void print_stitched(struct walker *w)
 {
-  int length = strlen(seq);
-  int i, j;
-  char base;
+  FILE *output = w->gw->output;
+  int n_columns = w->gw->n_columns;
+  struct walker *m = w->gw->walkers + w->mate;
+  char *left = m->contig, *right = w->contig + w->length_seed;
+  long int length_left = m->length_contig, length_right;
+  long int i, l;
+
+  length_right = w->length_contig - w->length_seed;
+  if (m->met >= 0) length_left = m->met;
+  left[length_left] = '\0';
+  complementary_sequence(left);
+  if (w->met >= 0) length_right = w->met - w->length_seed;
+  if (length_right < 0)	/* the end of the mate is in the initial seed */
+  {
+    length_left += length_right;
+    length_right = 0;
+  }
 
-  for (i = 0, j = length - 1; i <= j; i++, j--)
+  fprintf(output, ">%s\n", w->name);
+  for (i = 0; i < length_left + length_right; i += l)
   {
-    switch (seq[i])
+    l = length_left + length_right - i;
+    if (l > n_columns) l = n_columns;
+    if (i < length_left && i + l > length_left)
     {
-      case 'T': base = 'A'; break;
-      case 'C': base = 'G'; break;
-      case 'A': base = 'T'; break;
-      case 'G': base = 'C'; break;
-      default:  base = seq[i];
+      fwrite(left + i, 1, length_left - i, output);
+      fwrite(right, 1, i + l - length_left, output);
     }
-    switch (seq[j])
+    else if (i < length_left) { fwrite(left + i, 1, l, output); }
+    else { fwrite(right + i - length_left, 1, l, output); }
+    fputc('\n', output);
+  }
+}
+
+
+/*                                                                           */
+/* finish_walker()                                                           */
+/*                                                                           */
+/*   This function ends the walk with the code of N (see print_bases()).     */
+/*   Code 3 is used for exceeding the maximum length, code 2 for the ends    */
+/*   met on a circular genome, and code 1 for no more reads to extend the    */
+/*   sequence.  With option -C, the sequence is printed here.                */
+/*                                                                           */
+void finish_walker(struct walker *w, int code)
+{
+  char code_n[] = "NNNNNNN";
+
+  code_n[code] = '\0'; print_bases(w, code_n);
+  w->finished = (short int)code;
+  if (w->gw->circular && w->mate < 0) print_contig(w, code == 2);
+  if (w->gw->nominee)
+  {
+    if (w->gw->n_walkers > 1) { fprintf(w->gw->nominees, ">%s\n", w->name); }
+    print_nominee_table(w);
+  }
+  w->active = 0;
+}
+
+
+/*                                                                           */
+/* examine_sequence()                                                        */
+/*                                                                           */
+/*   This function searches a read for the seed of a walker on both strands  */
+/*   and passes a copy of the read to check_read() when the seed is found.   */
+/*   The read is copied only when the window from the seed has good          */
+/*   quality scores, and complemented only when the seed is on the minus     */
+/*   strand.  The quality scores are turned into q when the read holds a     */
+/*   seed for the first time.  The sequence should be in upper case; it is   */
+/*   not changed, so that other walkers can examine it.                      */
+/*   Id is the ordinal number of the read, held with option -D.              */
+/*   It returns 1 when the assembled sequence reaches the maximum length.    */
+/*                                                                           */
+int examine_sequence(struct walker *w, long int id, char *sequence,
+                     char *qscores, struct quality_runs *q)
+{
+  int offset, passing;
+  char strand_sequence[MAX_CHAR];
+
+  if ((w->strand = find_seed(w, sequence, &offset)) == 0) { return 0; }
+  hold_read(w, id, (int)strlen(sequence) - offset);
+  if (q->length < 0) quality_runs(w->gw, qscores, q);
+  if ((passing = window_passes(w->gw, q, offset, w->strand)))
+  {
+    strcpy(strand_sequence, sequence);
+    if (w->strand == 2) complementary_sequence(strand_sequence);
+  }
+  check_read(w, strand_sequence + offset, passing);
+  return w->length_assembled >= w->gw->maximum_length;
+}
+
+
+/*                                                                           */
+/* examine_walkers()                                                         */
+/*                                                                           */
+/*   This function lets every active walker examine a read.                  */
+/*   It returns the number of walkers still active.                          */
+/*                                                                           */
+int examine_walkers(struct grepwalk *gw, long int id,
+                    char *sequence, char *qscores)
+{
+  struct walker *walkers = gw->walkers;
+  struct quality_runs q;
+  int i, exceeding, n_active = 0;
+
+  uc_only_tcag(sequence);
+  q.length = -1;
+  for (i = 0; i < gw->n_walkers; i++)
+  {
+    if (!walkers[i].active) continue;
+    exceeding = examine_sequence(walkers + i, id, sequence, qscores, &q);
+    if (meet_mate(walkers + i)) continue;	/* the two ends have met */
+    if (close_circle(walkers + i)) continue;	/* gone around a circle */
+    if (exceeding) { finish_walker(walkers + i, 3); }
+  }
+  for (i = 0; i < gw->n_walkers; i++) n_active += walkers[i].active;
+  return n_active;
+}
+
+
+/*                                                                           */
+/* packed_scan()                                                             */
+/*                                                                           */
+/*   This function returns 1 when the seeds are searched for in the reads    */
+/*   of the store without unpacking them (see find_stored_seed()), i.e.      */
+/*   with option -a but neither -k nor -D, or 0 otherwise.                   */
+/*                                                                           */
+int packed_scan(struct grepwalk *gw)
+{ return gw->store != NULL && gw->index == NULL && !gw->dropping; }
+
+
+/*                                                                           */
+/* take_stored_read()                                                        */
+/*                                                                           */
+/*   This function moves *id past the next usable read of the store and      */
+/*   counts it up as scanned, without unpacking it.  It returns 0 when no    */
+/*   read is left.                                                           */
+/*                                                                           */
+int take_stored_read(struct grepwalk *gw, long int *id)
+{
+  struct read_store *s = gw->store;
+
+  while ((uint64_t)*id < s->n_reads && !usable_read(s, *id)) (*id)++;
+  if ((uint64_t)*id >= s->n_reads) return 0;
+  gw->stats.n_scanned++;
+  gw->stats.bytes_scanned += 2 * (long int)(s->offsets[*id + 1] -
+                                            s->offsets[*id]);
+  (*id)++;
+  return 1;
+}
+
+
+/*                                                                           */
+/* holds_seed()                                                              */
+/*                                                                           */
+/*   This function returns 1 when the id-th read of the store holds the      */
+/*   seed of an active walker, or 0 otherwise.                               */
+/*                                                                           */
+int holds_seed(struct grepwalk *gw, long int id)
+{
+  int i, offset;
+
+  for (i = 0; i < gw->n_walkers; i++)
+  {
+    if (gw->walkers[i].active &&
+        find_stored_seed(gw->walkers + i, gw->store, id, &offset))
+    { return 1; }
+  }
+  return 0;
+}
+
+
+/*                                                                           */
+/* take_read()                                                               */
+/*                                                                           */
+/*   This function gets the next read of the current pass from the file,     */
+/*   from the read store (option -a), or from reads holding one of the       */
+/*   seeds in the k-mer index (option -k).  The ordinal number of the read   */
+/*   plus one is left in *id.  Stored reads without a window of good         */
+/*   quality are skipped, and so are those holding no seed if packed_scan()  */
+/*   tells so, as they would not change the walk.  Reads and bytes of the    */
+/*   entries, or of the stored reads, are counted up.                        */
+/*   It returns 0 at the end of the pass.                                    */
+/*                                                                           */
+int take_read(struct grepwalk *gw, long int *id,
+              char *sequence, char *qscores)
+{
+  struct record_reader *fastq = gw->fastq;
+  struct walker *walkers = gw->walkers;
+  int i;
+  long int next, candidate, position;
+
+  if (gw->index != NULL)
+  {
+    for (;;)
     {
-      case 'T': seq[i] = 'A'; break;
-      case 'C': seq[i] = 'G'; break;
-      case 'A': seq[i] = 'T'; break;
-      case 'G': seq[i] = 'C'; break;
-      default:  seq[i] = seq[j];
+      for (next = -1, i = 0; i < gw->n_walkers; i++)
+      {
+        if (!walkers[i].active) continue;
+        candidate = next_indexed_read(gw->index, walkers[i].seed, *id);
+        if (candidate >= 0 && (next < 0 || candidate < next))
+        { next = candidate; }
+      }
+      if ((*id = next) < 0) return 0;
+      if (gw->store == NULL || usable_read(gw->store, next)) break;
+      *id = next + 1;	/* without a window of good quality */
     }
-    if (i == j) return length;
-    seq[j] = base;
+    if (gw->store == NULL)
+    { seek_records(fastq, indexed_read_offset(gw->index, *id)); }
+  }
+  if (packed_scan(gw))
+  {	/* unpacked only when it holds a seed */
+    do { if (!take_stored_read(gw, id)) return 0; }
+    while (!holds_seed(gw, *id - 1));
+    return fetch_stored_read(gw->store, *id - 1, sequence, qscores);
   }
-  return length;
+  if (gw->store != NULL)
+  {
+    while (gw->index == NULL && (uint64_t)*id < gw->store->n_reads &&
+           !usable_read(gw->store, *id))
+    { (*id)++; }
+    if (!fetch_stored_read(gw->store, (*id)++, sequence, qscores)) return 0;
+    gw->stats.n_scanned++;
+    gw->stats.bytes_scanned += 2 * (long int)strlen(sequence);
+    return 1;
+  }
+  (*id)++;
+  position = fastq->offset + (long int)fastq->position;
+  if (!read_record(fastq, sequence, qscores)) return 0;
+  gw->stats.n_scanned++;
+  gw->stats.bytes_scanned += fastq->offset + (long int)fastq->position -
+                             position;
+  return 1;
 }
 
 
-int read_reads(char *name_fastq)
+/*                                                                           */
+/* next_read()                                                               */
+/*                                                                           */
+/*   This function gets the next read of the current pass with take_read(),  */
+/*   or, with option -D, the next one that is not dropped (see               */
+/*   drop_reads.c).  It returns 0 at the end of the pass.                    */
+/*                                                                           */
+int next_read(struct grepwalk *gw, long int *id,
+              char *sequence, char *qscores)
 {
-  int i;
-  char line[MAX_CHAR];          /* to read one line */
+  if (gw->dropping && gw->index == NULL)
+  { return next_live_read(gw, id, sequence, qscores); }
+  while (take_read(gw, id, sequence, qscores))
+  { if (!gw->dropping || !drop_read(gw, *id - 1, qscores)) return 1; }
+  return 0;
+}
+
+
+/*                                                                           */
+/* read_reads()                                                              */
+/*                                                                           */
+/*   This function is called from walk_reads() to walk from the seeds on     */
+/*   the reads of the file, or on those kept in the store (option -a).       */
+/*   The sequences are printed onto gw->output in the order of the seeds.    */
+/*                                                                           */
+int read_reads(struct grepwalk *gw, char *name_fastq)
+{
+  int i, n_active, extended, resumed;
+  long int id;			/* ordinal number of a read */
   char sequence[MAX_CHAR];              /* to read one line */
   char qscores[MAX_CHAR];               /* to read one line */
-  char *seed_found;
-  FILE *fastq;
+  struct walker *walkers, *w;
 
-  /**** open the fastq or fasta file to read ****/
+  /**** open the fastq or fasta file to read, unless kept in memory ****/
 
-  if ((fastq = fopen(name_fastq, "r")) == NULL)
-  { fprintf(stderr, "File open error: %s\n", name_fastq); exit(222); }
-  init_extending_seq_table();
-  fprintf(stdout, ">%s\n", name);
-  print_bases(seed);
-  length_assembled = length_initial_seed;
+  if (gw->bidirectional) pair_walkers(gw);
+  walkers = gw->walkers;
+  if (gw->store == NULL &&
+      (gw->fastq = open_records(name_fastq, gw->n_threads)) == NULL)
+  { fail_walk(222, "File open error: %s", name_fastq); }
+  if (gw->store == NULL && !gw->dropping && !seekable_records(gw->fastq))
+  {	/* each pass reads the file again from its beginning */
+    fail_walk(222, "File open error: %s cannot be read again; "
+              "use option -a or -D", name_fastq);
+  }
+  resumed = (gw->resuming || gw->extending) &&
+            load_checkpoint(gw, name_fastq);
+  for (i = 0; i < gw->n_walkers; i++)
+  {	/* sequences are kept in temporary files if two or more seeds */
+    w = walkers + i;
+    if (gw->n_walkers > 1 && (w->output = tmpfile()) == NULL)
+    { ERROR_MESSAGE(229, "temporary file for a seed"); }
+    if (!gw->circular || w->mate >= 0) fprintf(w->output, ">%s\n", w->name);
+    if (resumed) replay_walker(w);	/* from the checkpoint (option -R) */
+    else print_bases(w, w->seed);
+  }
+  for (n_active = i = 0; i < gw->n_walkers; i++) n_active += walkers[i].active;
+  if (gw->dropping) open_working_set(gw);
+  if (n_active == 0) goto over;	/* resumed after the walk was over */
 
-  /**** read line by line ****/
+  /**** read line by line, or only reads holding the seed if indexed ****/
 
-  endless: while (fgets(line, MAX_CHAR, fastq) != NULL)
+  endless: id = gw->first_read;
+  gw->stats.n_passes++;
+  switch_phase(&gw->stats, PHASE_SCAN);
+  if (gw->n_threads > 1) { n_active = scan_reads(gw); }
+  else
   {
-    if (line[0] == '@')
-    {
-      if (fgets(sequence, MAX_CHAR, fastq) == NULL) goto exit223;
-      sequence[strlen(sequence) - 1] = '\0';
-      if (fgets(qscores, MAX_CHAR, fastq) == NULL) goto exit223;
-      ;	/* do nothing; read out the third line */
-      if (fgets(qscores, MAX_CHAR, fastq) == NULL) goto exit223;
-      qscores[strlen(qscores) - 1] = '\0';
-    }
-    else if (line[0] == '>')
-    {
-      if (fgets(sequence, MAX_CHAR, fastq) == NULL) goto exit223;
-      sequence[strlen(sequence) - 1] = '\0';
-      for (i = 0; i < (int)strlen(sequence); i++) { qscores[i] = HIGH_QSCORE; }
-      qscores[i] = '\0';
+    while (n_active > 0 && next_read(gw, &id, sequence, qscores))
+    { n_active = examine_walkers(gw, id - 1, sequence, qscores); }
+  }
+  gw->first_read = 0;
+  switch_phase(&gw->stats, PHASE_STRUGGLE);
+  for (i = 0; i < gw->n_walkers; i++)
+  {
+    w = walkers + i;
+    if (!w->active) continue;
+    if (w->loop_counter) { w->loop_counter = 0; continue; }
+    extended = lastly_struggle(w) > 0;
+    if (extended && meet_mate(w)) continue;	/* the two ends have met */
+    if (extended && close_circle(w)) continue;	/* gone around a circle */
+    if (extended && gw->keep_walking)
+    {	/* walk again from the moved seed */
+      init_extending_seq_table(w);
+      if (w->length_assembled < gw->maximum_length) continue;
+      finish_walker(w, 3);
     }
     else
-    { exit223:
-      fprintf(stderr, "File format error: %s", line);
-      fclose(fastq);
-      exit(223);
-    }
-    uc_only_tcag(sequence);
-
-    if ((seed_found = strstr(sequence, seed)) == NULL)
-    {
-      complementary_sequence(sequence);
-      if ((seed_found = strstr(sequence, seed)) == NULL) { continue; }
-      else { reverse_sequence(qscores); strand = 2; }
-    }
-    else { strand = 1; }
-    check_read(seed_found, qscores + (seed_found - sequence));
-    if (length_assembled >= maximum_length)
-    {
-      ns[3] = '\0'; print_bases(ns);	/* exceeding the maximum length */
-      if (nominee) { print_nominee_table(); }
-      return EXIT_SUCCESS;
+    {	/* no such reads any longer */
+      w->starved = !extended;
+      finish_walker(w, 1);
     }
   }
-  if (loop_counter)
+  for (n_active = i = 0; i < gw->n_walkers; i++) n_active += walkers[i].active;
+  if (n_active > 0)
   {
-    fseek(fastq, 0L, SEEK_SET);
-    loop_counter = 0;
+    if (gw->checkpoint[0] != '\0') write_checkpoint(gw, name_fastq);
+    if (gw->dropping) pass_working_set(gw);
+    else if (gw->store == NULL) seek_records(gw->fastq, 0L);
     goto endless;
   }
-  else
-  {
-    lastly_struggle();
-    ns[1] = '\0'; print_bases(ns);
-  }	/* no such reads any longer */
 
-  fclose(fastq);
-  if (nominee) { print_nominee_table(); }
+  over:
+  if (gw->store == NULL) { close_records(gw->fastq); gw->fastq = NULL; }
+  if (gw->checkpoint[0] != '\0') write_checkpoint(gw, name_fastq);
+  switch_phase(&gw->stats, PHASE_OUTPUT);
+  for (i = 0; i < gw->n_walkers && gw->n_walkers > 1; i++)
+  {	/* print the sequences in the order of the seeds */
+    w = walkers + i;
+    if (w->mate >= 0)
+    {	/* a walker and its mate are printed as one sequence */
+      if (w->mate > i) print_stitched(w);
+    }
+    else
+    {
+      rewind(w->output);
+      while (fgets(sequence, MAX_CHAR, w->output) != NULL)
+      { fputs(sequence, gw->output); }
+    }
+    fclose(w->output);
+    w->output = NULL;
+  }
+  close_walk_stats(&gw->stats);
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,212 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   read_store.c - keep all reads in memory in a packed form                */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from read_reads.c when option -a is provided.     */
+/*   A fastq or fasta file is read only once, and each base is kept with     */
+/*   two bits for T, C, A, or G, one bit for other characters (N), and one   */
+/*   bit telling whether its quality score is between minimum_qscore and     */
+/*   MAX_QSCORE.  Reads are concatenated and an offset array points to the   */
+/*   first base of each read.  A read is marked as usable when it has        */
+/*   window bases of good quality in a row; the others, which check_read()   */
+/*   always rejects, are skipped in every pass.                              */
+/*   The seeds are searched for in the packed bases (see find_stored_seed()  */
+/*   in seed_matcher.c), and only the reads holding a seed are unpacked.     */
+/*   Because the file is not read again, the standard input can be used      */
+/*   by giving "-" as the file name.  Reads trimmed and merged in memory     */
+/*   (option -P) are packed one by one with store_read().                    */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Read entries with record_reader.c                         */
+/*   Oct 17, 2026  Split store_read() for reads merged in memory (-P)        */
+/*   Oct 17, 2026  Keep the reads in struct read_store for libgrepwalk       */
+/*   Oct 17, 2026  Mark reads having window bases of good quality in a row   */
+/*   Oct 17, 2026  load_read_store() reads a file opened by the caller       */
+/*   Oct 17, 2026  Take no score beyond the quality line; use MAX_QSCORE of  */
+/*                 examine_reads.h                                           */
+/*                                                                           */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "defaults.h"
+#include "grepwalk.h"
+#include "examine_reads.h"
+#include "record_reader.h"
+
+#define PASS_QSCORE (char)(s->minimum_qscore - CODE_TO_SCORE)
+#define FAIL_QSCORE (char)(MAX_QSCORE + 1 - CODE_TO_SCORE)
+
+
+void uc_only_tcag(char *);
+int read_record(struct record_reader *, char *, char *);
+
+
+void *grow_store(void *array, uint64_t size_old, uint64_t size_new)
+{	/* the added part is filled with zeros */
+  if ((array = realloc(array, (size_t)size_new)) == NULL)
+  { ERROR_MESSAGE(226, "memory allocation for the read store"); }
+  memset((char *)array + size_old, 0, (size_t)(size_new - size_old));
+  return array;
+}
+
+
+/*                                                                           */
+/* new_read_store()                                                          */
+/*                                                                           */
+/*   This function prepares an empty store, in which the quality scores of   */
+/*   the bases are examined with minimum_qscore and the reads with window.   */
+/*                                                                           */
+struct read_store *new_read_store(int minimum_qscore, int window)
+{
+  struct read_store *s;
+
+  s = (struct read_store *)grow_store(NULL, 0, sizeof(struct read_store));
+  s->minimum_qscore = minimum_qscore;
+  s->window = window;
+  s->size_reads = 0x10000;
+  s->size_bases = 0x100000;
+  s->offsets = grow_store(NULL, 0, s->size_reads * sizeof(uint64_t));
+  s->usable = grow_store(NULL, 0, s->size_reads / 8);
+  s->bases = grow_store(NULL, 0, s->size_bases / 4);
+  s->ns = grow_store(NULL, 0, s->size_bases / 8);
+  s->passes = grow_store(NULL, 0, s->size_bases / 8);
+  return s;
+}
+
+
+void free_read_store(struct read_store *s)
+{
+  free(s->offsets);
+  free(s->bases);
+  free(s->ns);
+  free(s->passes);
+  free(s->usable);
+  free(s);
+}
+
+
+/*                                                                           */
+/* store_read()                                                              */
+/*                                                                           */
+/*   This function packs one read into the store, which is enlarged as       */
+/*   needed.                                                                 */
+/*                                                                           */
+void store_read(struct read_store *s, char *sequence, char *qscores)
+{
+  int i, l, lq, passing, run = 0;
+  short int qscore;
+  uint64_t n;
+
+  uc_only_tcag(sequence);
+  l = (int)strlen(sequence);
+  lq = (int)strlen(qscores);
+  n = s->offsets[s->n_reads];
+  if (s->n_reads + 1 >= s->size_reads)
+  {
+    s->offsets = grow_store(s->offsets, s->size_reads * sizeof(uint64_t),
+                            2 * s->size_reads * sizeof(uint64_t));
+    s->usable = grow_store(s->usable, s->size_reads / 8, s->size_reads / 4);
+    s->size_reads *= 2;
+  }
+  while (n + (uint64_t)l > s->size_bases)
+  {
+    s->bases = grow_store(s->bases, s->size_bases / 4, s->size_bases / 2);
+    s->ns = grow_store(s->ns, s->size_bases / 8, s->size_bases / 4);
+    s->passes = grow_store(s->passes, s->size_bases / 8, s->size_bases / 4);
+    s->size_bases *= 2;
+  }
+
+  for (i = 0; i < l; i++, n++)
+  {
+    switch (sequence[i])
+    {
+      case 'T': s->bases[n / 4] |= 3 << (2 * (n % 4)); break;
+      case 'C': s->bases[n / 4] |= 1 << (2 * (n % 4)); break;
+      case 'A': break;
+      case 'G': s->bases[n / 4] |= 2 << (2 * (n % 4)); break;
+      default:  s->ns[n / 8] |= 1 << (n % 8);
+    }
+    passing = 0;
+    if (i < lq)
+    {	/* a short line of quality scores has none for the rest */
+      qscore = (short int)qscores[i] + CODE_TO_SCORE;
+      passing = s->minimum_qscore <= qscore && qscore <= MAX_QSCORE;
+    }
+    if (passing)
+    {
+      s->passes[n / 8] |= 1 << (n % 8);
+      if (++run == s->window)
+      { s->usable[s->n_reads / 8] |= 1 << (s->n_reads % 8); }
+    }
+    else { run = 0; }
+  }
+  s->offsets[++s->n_reads] = n;
+}
+
+
+/*                                                                           */
+/* load_read_store()                                                         */
+/*                                                                           */
+/*   This function reads all the reads of a fastq or fasta file opened by    */
+/*   the caller and packs them into the store.  It returns the number of     */
+/*   reads.                                                                  */
+/*                                                                           */
+long int load_read_store(struct read_store *s, struct record_reader *fastq)
+{
+  char sequence[MAX_CHAR];
+  char qscores[MAX_CHAR];
+
+  while (read_record(fastq, sequence, qscores))
+  { store_read(s, sequence, qscores); }
+  return (long int)s->n_reads;
+}
+
+
+/*                                                                           */
+/* usable_read()                                                             */
+/*                                                                           */
+/*   This function returns 1 when the id-th read has window bases of good    */
+/*   quality in a row, or 0 otherwise or when there is no such read.         */
+/*                                                                           */
+int usable_read(struct read_store *s, long int id)
+{
+  if (id < 0 || (uint64_t)id >= s->n_reads) return 0;
+  return (s->usable[id / 8] >> (id % 8)) & 1;
+}
+
+
+/*                                                                           */
+/* fetch_stored_read()                                                       */
+/*                                                                           */
+/*   This function unpacks the id-th read into a sequence and a string of    */
+/*   quality scores that check_read() can examine: PASS_QSCORE is used for   */
+/*   bases of good quality and FAIL_QSCORE for the others.                   */
+/*   It returns 0 when there is no such read.                                */
+/*                                                                           */
+int fetch_stored_read(struct read_store *s, long int id,
+                      char *sequence, char *qscores)
+{
+  static const char bases[] = "ACGT";
+  uint64_t n, end;
+  int i;
+
+  if (id < 0 || (uint64_t)id >= s->n_reads) return 0;
+  end = s->offsets[id + 1];
+  for (i = 0, n = s->offsets[id]; n < end; i++, n++)
+  {
+    if (s->ns[n / 8] & (1 << (n % 8))) { sequence[i] = 'N'; }
+    else { sequence[i] = bases[(s->bases[n / 4] >> (2 * (n % 4))) & 3]; }
+    qscores[i] = (s->passes[n / 8] & (1 << (n % 8))) ?
+                 PASS_QSCORE : FAIL_QSCORE;
+  }
+  sequence[i] = qscores[i] = '\0';
+  return 1;
+}
@@ -0,0 +1,333 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   record_reader.c - find entries of fastq and fasta files without copies  */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from count_bases.c, trim_bases.c, merge_fastq.c,  */
+/*   read_reads.c, read_store.c, kmer_index.c, and drop_reads.c.             */
+/*   A regular file is mapped into memory, and other files such as the       */
+/*   standard input ("-") are read into a buffer that grows as needed.       */
+/*   Lines are found with memchr() and returned as pointers into the         */
+/*   mapping or the buffer with their lengths, so that nothing is copied.    */
+/*   A gzip or BGZF file, recognized by its first bytes, is decompressed     */
+/*   into the buffer in bgzf.c; seeking backward in it means reading it      */
+/*   again from the beginning.                                               */
+/*   An entry beginning with '>' has two lines, and any other has four.      */
+/*   Entries returned by next_records() are valid until the next call.       */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Give n_threads to open_records() instead of a global      */
+/*   Oct 17, 2026  Add reopen_records() for reads rewritten with option -D   */
+/*   Oct 17, 2026  Add seekable_records(); raise an error if a seek fails    */
+/*   Oct 17, 2026  Free the reader before an error is raised                 */
+/*   Oct 17, 2026  Keep the buffer when it cannot be enlarged                */
+/*                                                                           */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "defaults.h"
+#include "record_reader.h"
+#include "bgzf.h"
+
+#define SIZE_STREAM 0x100000
+
+
+struct gz_input *open_gz_input(FILE *, char *, int, int);
+void close_gz_input(struct gz_input *);
+int rewind_gz_input(struct gz_input *);
+size_t read_gz_input(struct gz_input *, char *, size_t);
+
+
+int is_gzip(unsigned char *magic)
+{
+  return magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+
+/*                                                                           */
+/* open_records()                                                            */
+/*                                                                           */
+/*   This function opens a fastq or fasta file; "-" is the standard input.   */
+/*   A BGZF file is decompressed in n_threads threads.                       */
+/*   It returns NULL when the file cannot be opened.                         */
+/*                                                                           */
+struct record_reader *open_records(char *name, int n_threads)
+{
+  struct record_reader *r;
+  struct stat st;
+  unsigned char magic[2];
+  int fd;
+
+  if ((r = (struct record_reader *)calloc(1, sizeof(*r))) == NULL)
+  { ERROR_MESSAGE(226, "memory allocation for reading a file"); }
+
+  if (strcmp(name, "-"))
+  {
+    if ((fd = open(name, O_RDONLY)) < 0) { free(r); return NULL; }
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        !(pread(fd, magic, 2, 0) == 2 && is_gzip(magic)))
+    {
+      r->data = (char *)mmap(NULL, (size_t)st.st_size, PROT_READ,
+                             MAP_PRIVATE, fd, 0);
+      if (r->data != MAP_FAILED)
+      {
+        madvise(r->data, (size_t)st.st_size, MADV_SEQUENTIAL);
+        close(fd);
+        r->size = (size_t)st.st_size;
+        r->mapped = r->eof = 1;
+        return r;
+      }
+    }
+    close(fd);
+    if ((r->fp = fopen(name, "r")) == NULL) { free(r); return NULL; }
+  }
+  else { r->fp = stdin; }
+
+  r->size_buffer = SIZE_STREAM;
+  if ((r->data = (char *)malloc(r->size_buffer)) == NULL)
+  {
+    if (r->fp != stdin) fclose(r->fp);
+    free(r);
+    ERROR_MESSAGE(226, "memory allocation for reading a file");
+  }
+
+  r->size = fread(r->data, 1, 2, r->fp);
+  if (r->size == 2 && is_gzip((unsigned char *)r->data))
+  {
+    r->gz = open_gz_input(r->fp, r->data, 2, n_threads);
+    r->size = 0;
+  }
+  return r;
+}
+
+
+/*                                                                           */
+/* reopen_records()                                                          */
+/*                                                                           */
+/*   This function prepares a reader of the entries written into a stream,   */
+/*   e.g. a temporary file, from its beginning.  The stream is closed by     */
+/*   close_records().                                                        */
+/*                                                                           */
+struct record_reader *reopen_records(FILE *fp)
+{
+  struct record_reader *r;
+
+  if ((r = (struct record_reader *)calloc(1, sizeof(*r))) == NULL)
+  { ERROR_MESSAGE(226, "memory allocation for reading a file"); }
+  r->fp = fp;
+  r->size_buffer = SIZE_STREAM;
+  if ((r->data = (char *)malloc(r->size_buffer)) == NULL)
+  { free(r); ERROR_MESSAGE(226, "memory allocation for reading a file"); }
+  rewind(fp);
+  return r;
+}
+
+
+void close_records(struct record_reader *r)
+{
+  if (r->mapped) { munmap(r->data, r->size); }
+  else
+  {
+    if (r->gz != NULL) close_gz_input(r->gz);
+    if (r->fp != stdin) fclose(r->fp);
+    free(r->data);
+  }
+  free(r);
+}
+
+
+/*                                                                           */
+/* tell_records() and seek_records()                                         */
+/*                                                                           */
+/*   These functions work as ftell() and fseek() do.  The position told      */
+/*   is that of the entry that next_records() returns next.  A seek that     */
+/*   fails, e.g. back in a pipe, is an error rather than an early end.       */
+/*                                                                           */
+long int tell_records(struct record_reader *r)
+{
+  return r->offset + (long int)r->position;
+}
+
+
+void seek_records(struct record_reader *r, long int offset)
+{
+  if (r->mapped) { r->position = (size_t)offset; }
+  else if (offset >= r->offset && offset <= r->offset + (long int)r->size)
+  { r->position = (size_t)(offset - r->offset); }
+  else if (r->gz != NULL)
+  {
+    if (offset < r->offset)
+    {
+      if (rewind_gz_input(r->gz))
+      { ERROR_MESSAGE(222, "seek in a file that cannot be read again"); }
+      r->offset = 0;
+      r->size = r->position = 0;
+      r->eof = 0;
+    }
+    while (offset > r->offset + (long int)r->size && !r->eof)
+    {	/* bytes before the offset are discarded */
+      r->offset += (long int)r->size;
+      r->size = read_gz_input(r->gz, r->data, r->size_buffer);
+      if (r->size < r->size_buffer) r->eof = 1;
+    }
+    r->position = offset > r->offset + (long int)r->size ?
+                  r->size : (size_t)(offset - r->offset);
+  }
+  else
+  {
+    if (fseek(r->fp, offset, SEEK_SET) != 0)
+    { ERROR_MESSAGE(222, "seek in a file that cannot be read again"); }
+    r->offset = offset;
+    r->size = r->position = 0;
+    r->eof = 0;
+  }
+  r->error = 0;
+}
+
+
+/*                                                                           */
+/* seekable_records()                                                        */
+/*                                                                           */
+/*   This function returns 1 if the file can be read again from an earlier   */
+/*   position, or 0 if not, e.g. a pipe given as "-".                        */
+/*                                                                           */
+int seekable_records(struct record_reader *r)
+{
+  return r->mapped || fseek(r->fp, 0L, SEEK_CUR) == 0;
+}
+
+
+/*                                                                           */
+/* find_line()                                                               */
+/*                                                                           */
+/*   This function finds the end of the line beginning at from.  The last    */
+/*   line of a file may lack the new line.  It returns 1 when found, 0 when  */
+/*   more bytes should be read, or -1 at the end of the file.                */
+/*                                                                           */
+int find_line(struct record_reader *r, size_t from, size_t *end)
+{
+  char *p;
+
+  if (from >= r->size && r->eof) return -1;
+  if (from < r->size &&
+      (p = (char *)memchr(r->data + from, '\n', r->size - from)) != NULL)
+  {
+    *end = (size_t)(p - r->data);
+    return 1;
+  }
+  if (r->eof) { *end = r->size; return 1; }
+  return 0;
+}
+
+
+/*                                                                           */
+/* parse_record()                                                            */
+/*                                                                           */
+/*   This function finds the lines of the entry at the current position.     */
+/*   It returns 1 when found, 0 when more bytes should be read, -1 at the    */
+/*   end of the file, or -2 when the entry is broken.                        */
+/*                                                                           */
+int parse_record(struct record_reader *r, struct record *record)
+{
+  size_t start[4], end[4], from = r->position;
+  int i, found, n_lines = 4;
+
+  for (i = 0; i < n_lines; i++)
+  {
+    if ((found = find_line(r, from, &end[i])) == 0) return 0;
+    if (found < 0)
+    {
+      if (i == 0) return -1;
+      r->error = i;
+      return -2;
+    }
+    start[i] = from;
+    from = end[i] + 1;
+    if (i == 0 && r->data[start[0]] == '>') n_lines = 2;
+  }
+  r->position = from < r->size ? from : r->size;
+
+  record->offset = r->offset + (long int)start[0];
+  record->header = r->data + start[0];
+  record->length_header = (int)(end[0] - start[0]);
+  record->sequence = r->data + start[1];
+  record->length_sequence = (int)(end[1] - start[1]);
+  if (n_lines == 2)
+  {
+    record->third = record->qscores = NULL;
+    record->length_third = record->length_qscores = 0;
+  }
+  else
+  {
+    record->third = r->data + start[2];
+    record->length_third = (int)(end[2] - start[2]);
+    record->qscores = r->data + start[3];
+    record->length_qscores = (int)(end[3] - start[3]);
+  }
+  return 1;
+}
+
+
+/*                                                                           */
+/* next_records()                                                            */
+/*                                                                           */
+/*   This function finds at most size entries from the current position.     */
+/*   It returns the number of entries found; 0 at the end of the file or     */
+/*   when the next entry is broken, in which case r->error is not 0.         */
+/*   For a stream, the bytes of the entries returned last time are           */
+/*   discarded when the buffer is full, or the buffer is enlarged for an     */
+/*   entry longer than the buffer.                                           */
+/*                                                                           */
+int next_records(struct record_reader *r, struct record *records, int size)
+{
+  int n = 0, status;
+  size_t n_read;
+  char *data;
+
+  while (n < size && r->error == 0)
+  {
+    if ((status = parse_record(r, records + n)) == 1) { n++; continue; }
+    if (status < 0) break;
+
+    if (r->size == r->size_buffer)
+    {
+      if (n > 0) break;	/* entries found should not be moved */
+      if (r->position > 0)
+      {
+        memmove(r->data, r->data + r->position, r->size - r->position);
+        r->offset += (long int)r->position;
+        r->size -= r->position;
+        r->position = 0;
+      }
+      else
+      {
+        data = (char *)realloc(r->data, 2 * r->size_buffer);
+        if (data == NULL)	/* kept until the reader is closed */
+        { ERROR_MESSAGE(226, "memory allocation for reading a file"); }
+        r->data = data;
+        r->size_buffer *= 2;
+      }
+    }
+    if (r->gz != NULL)
+    {
+      n_read = read_gz_input(r->gz, r->data + r->size,
+                             r->size_buffer - r->size);
+    }
+    else
+    { n_read = fread(r->data + r->size, 1, r->size_buffer - r->size, r->fp); }
+    if (n_read == 0) r->eof = 1;
+    r->size += n_read;
+  }
+  return n;
+}
@@ -0,0 +1,50 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   record_reader.h - header file for record_reader.c                       */
+/*                                                                           */
+/* SYNOPSIS                                                                  */
+/*   #include "record_reader.h"                                              */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This is a header file for record_reader.c, in which entries of fastq    */
+/*   and fasta files are found without copying them.                         */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*                                                                           */
+
+
+#define SIZE_RECORDS 0x400
+	/* number of entries returned at once by next_records() */
+
+/**** one entry; lines are not terminated with '\0' nor '\n' ****/
+struct record
+{
+  char *header;
+  int length_header;
+  char *sequence;
+  int length_sequence;
+  char *third;			/* the line beginning with '+' */
+  int length_third;
+  char *qscores;		/* NULL for a fasta entry */
+  int length_qscores;
+  long int offset;		/* file position of the entry */
+};
+
+/**** a mapped file, or a buffer of a stream ****/
+struct record_reader
+{
+  FILE *fp;			/* NULL when the file is mapped */
+  struct gz_input *gz;		/* not NULL for a gzip or BGZF file */
+  char *data;
+  size_t size;			/* bytes in data */
+  size_t position;		/* next byte to be examined */
+  size_t size_buffer;		/* bytes allocated for a stream */
+  long int offset;		/* file position of data[0] */
+  short int mapped;
+  short int eof;		/* no more bytes in the stream */
+  int error;			/* lines read of a broken entry, if any */
+};
@@ -0,0 +1,255 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   scan_reads.c - search reads for the seed in several threads             */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from read_reads.c when option -j is provided      */
+/*   with two or more threads.                                               */
+/*   Reads are taken in batches in the order of the file.  The threads       */
+/*   search their own parts of a batch for the seed of each walker on both   */
+/*   strands, and then the reads holding a seed are passed to check_read()   */
+/*   one by one in the original order.  When a seed is extended in the       */
+/*   middle of a batch, the rest of the batch is searched again for the new  */
+/*   seed, so that the result is the same as the one without threads.        */
+/*   Reads kept in the store (option -a) are searched in their packed form   */
+/*   and unpacked only when they hold a seed (see packed_scan()).            */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Search for the seeds of all the walkers                   */
+/*   Oct 17, 2026  Use find_seed() instead of strstr() on both strands       */
+/*   Oct 17, 2026  Read entries with record_reader.c                         */
+/*   Oct 17, 2026  Stop a walker and its mate when the two ends meet (-B)    */
+/*   Oct 17, 2026  Keep the batch in the context of the walk                 */
+/*   Oct 17, 2026  Hold reads holding a seed for option -D                   */
+/*   Oct 17, 2026  Look up the quality window instead of reversing scores    */
+/*   Oct 17, 2026  Stop a walker that goes around a circle (option -C)       */
+/*   Oct 17, 2026  Start the first pass from the reads appended (option -E)  */
+/*   Oct 17, 2026  Join the threads created before an error is raised        */
+/*   Oct 17, 2026  Search stored reads packed; unpack those holding a seed   */
+/*                                                                           */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "defaults.h"
+#include "grepwalk.h"
+#include "examine_reads.h"
+#include "record_reader.h"
+
+#define SIZE_BATCH 0x1000
+
+void uc_only_tcag(char *);
+int complementary_sequence(char *);
+int check_read(struct walker *, char *, int);
+void quality_runs(struct grepwalk *, char *, struct quality_runs *);
+int window_passes(struct grepwalk *, struct quality_runs *, int, short int);
+int next_read(struct grepwalk *, long int *, char *, char *);
+int find_seed(struct walker *, char *, int *);
+int find_stored_seed(struct walker *, struct read_store *, long int, int *);
+int fetch_stored_read(struct read_store *, long int, char *, char *);
+int packed_scan(struct grepwalk *);
+int take_stored_read(struct grepwalk *, long int *);
+void finish_walker(struct walker *, int);
+int meet_mate(struct walker *);
+int close_circle(struct walker *);
+void hold_read(struct walker *, long int, int);
+
+
+/**** a read in a batch ****/
+struct batch_read
+{
+  long int id;		/* ordinal number of the read plus one */
+  char sequence[MAX_CHAR];	/* empty while packed in the store */
+  char qscores[MAX_CHAR];
+};
+
+/**** where the seed of a walker is found in a read ****/
+struct hit
+{
+  short int strand;	/* 0: seed not found; 1: plus; 2: minus strand */
+  int offset;		/* position of the seed on the strand */
+};
+
+/**** reads searched by one thread ****/
+struct slice
+{
+  struct grepwalk *gw;
+  int first;
+  int last;
+  int walker;		/* -1 for all the active walkers */
+  int packed;		/* 1 if the reads are searched in the store */
+};
+
+
+void *match_slice(void *arg)
+{
+  struct slice *s = (struct slice *)arg;
+  struct grepwalk *gw = s->gw;
+  struct batch_read *read;
+  struct hit *hit;
+  int i, k;
+
+  for (i = s->first; i < s->last; i++)
+  {
+    read = gw->batch + i;
+    if (s->walker < 0 && !s->packed) uc_only_tcag(read->sequence);
+    for (k = 0; k < gw->n_walkers; k++)
+    {
+      if ((s->walker >= 0 && s->walker != k) || !gw->walkers[k].active)
+      { continue; }
+      hit = gw->hits + i * gw->n_walkers + k;	/* read i, walker k */
+      if (s->packed)
+      {
+        hit->strand = find_stored_seed(gw->walkers + k, gw->store,
+                                       read->id - 1, &hit->offset);
+      }
+      else
+      {
+        hit->strand = find_seed(gw->walkers + k, read->sequence,
+                                &hit->offset);
+      }
+    }
+  }
+  return NULL;
+}
+
+
+/*                                                                           */
+/* match_batch()                                                             */
+/*                                                                           */
+/*   This function divides reads from first to last (exclusive) into         */
+/*   n_threads slices and searches them at the same time for the seed of     */
+/*   a walker, or for the seeds of all the walkers if walker is -1.          */
+/*                                                                           */
+void match_batch(struct grepwalk *gw, int first, int last, int walker)
+{
+  pthread_t threads[MAX_THREADS];
+  struct slice slices[MAX_THREADS];
+  int n_threads = gw->n_threads;
+  int n = last - first;
+  int size = (n + n_threads - 1) / n_threads;
+  int t, n_created;
+
+  for (t = 0; t < n_threads; t++)
+  {
+    slices[t].gw = gw;
+    slices[t].first = first + (t * size < n ? t * size : n);
+    slices[t].last = first + ((t + 1) * size < n ? (t + 1) * size : n);
+    slices[t].walker = walker;
+    slices[t].packed = packed_scan(gw);
+  }
+  for (t = 1; t < n_threads; t++)
+  { if (pthread_create(&threads[t], NULL, match_slice, &slices[t])) break; }
+  n_created = t;
+  if (n_created == n_threads) match_slice(&slices[0]);
+  for (t = 1; t < n_created; t++) pthread_join(threads[t], NULL);
+  if (n_created < n_threads)
+  { ERROR_MESSAGE(227, "thread creation"); }	/* after the slices ended */
+}
+
+
+/*                                                                           */
+/* scan_reads()                                                              */
+/*                                                                           */
+/*   This function performs one pass over the reads.                         */
+/*   It returns the number of walkers still active at the end of the pass.   */
+/*                                                                           */
+int scan_reads(struct grepwalk *gw)
+{
+  int i, k, n, n_active, extended, passing, packed = packed_scan(gw);
+  short int counter;
+  long int id = gw->first_read;
+  char sequence[MAX_CHAR];
+  struct quality_runs q;
+  struct batch_read *batch = gw->batch, *read;
+  struct walker *w;
+  struct hit *hit;
+
+  if (batch == NULL)
+  {
+    gw->batch = batch = (struct batch_read *)malloc(SIZE_BATCH *
+                                                    sizeof(struct batch_read));
+    gw->hits = (struct hit *)malloc(SIZE_BATCH * gw->n_walkers *
+                                    sizeof(struct hit));
+    if (batch == NULL || gw->hits == NULL)
+    { ERROR_MESSAGE(226, "memory allocation for a batch of reads"); }
+  }
+
+  for (n_active = k = 0; k < gw->n_walkers; k++)
+  { n_active += gw->walkers[k].active; }
+  while (n_active > 0)
+  {
+    for (n = 0; n < SIZE_BATCH; n++)
+    {
+      if (packed)
+      {	/* unpacked when a seed is found */
+        if (take_stored_read(gw, &id) == 0) break;
+        batch[n].sequence[0] = '\0';
+      }
+      else if (next_read(gw, &id, batch[n].sequence, batch[n].qscores) == 0)
+      { break; }
+      batch[n].id = id;
+    }
+    if (n == 0) break;
+    match_batch(gw, 0, n, -1);
+
+    for (i = 0; i < n && n_active > 0; i++)
+    {
+      read = batch + i;
+      q.length = -1;	/* turned when the read holds a seed */
+      for (extended = k = 0; k < gw->n_walkers; k++)
+      {
+        w = gw->walkers + k;
+        hit = gw->hits + i * gw->n_walkers + k;
+        if (!w->active || hit->strand == 0) continue;
+        if (packed && read->sequence[0] == '\0')
+        {
+          fetch_stored_read(gw->store, read->id - 1,
+                            read->sequence, read->qscores);
+        }
+        hold_read(w, read->id - 1,
+                  (int)strlen(read->sequence) - hit->offset);
+
+        if (q.length < 0) quality_runs(gw, read->qscores, &q);
+        if ((passing = window_passes(gw, &q, hit->offset, hit->strand)))
+        {
+          strcpy(sequence, read->sequence);
+          if (hit->strand == 2) complementary_sequence(sequence);
+        }
+        w->strand = hit->strand;
+        counter = w->loop_counter;
+        check_read(w, sequence + hit->offset, passing);
+        if (meet_mate(w))
+        {	/* the two ends have met; the mate is finished as well */
+          n_active -= 2;
+          continue;
+        }
+        if (close_circle(w))
+        {	/* the walk has gone around a circular genome */
+          n_active--;
+          continue;
+        }
+        if (w->length_assembled >= gw->maximum_length)
+        {	/* exceeding the maximum length */
+          finish_walker(w, 3);
+          n_active--;
+          continue;
+        }
+        if (counter == w->loop_counter || i + 1 == n) continue;
+
+        /* the seed is extended; reads left in the batch are searched again */
+        extended = 1;
+        if (gw->index == NULL) match_batch(gw, i + 1, n, k);
+      }
+      if (extended && gw->index != NULL)
+      { id = read->id; break; }	/* look up */
+    }
+  }
+  return n_active;
+}
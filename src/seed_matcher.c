@@ -0,0 +1,212 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   seed_matcher.c - find the seed on both strands of a read in one scan    */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from read_reads.c and scan_reads.c.               */
+/*   When the seed of a walker is changed, the seed and its reverse          */
+/*   complement are encoded with two bits per base into words of 32 bases;   */
+/*   the last word is taken from the last 32 bases, and may overlap the      */
+/*   previous one.  Each read is scanned only once with a rolling code of    */
+/*   the last 32 bases (or of the seed length, if shorter), which is reset   */
+/*   by a base other than T, C, A, or G.  Since a code stands for its bases  */
+/*   exactly, a seed of 32 bases or less is matched with one comparison,     */
+/*   and a longer one with one comparison per word, looking up the codes     */
+/*   kept at the ends of the earlier words.  The read is complemented by     */
+/*   the caller only when the seed is on the minus strand.                   */
+/*   A hit is reported at the same position as strstr() would find it in     */
+/*   the read, or else in its complementary sequence.                        */
+/*   Reads kept in the store (option -a) are scanned in their packed form,   */
+/*   whose two bits of a base are the same as the code, so that only the     */
+/*   reads holding a seed have to be unpacked.                               */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Compare codes of 32 bases instead of verifying strncmp()  */
+/*   Oct 17, 2026  Add find_stored_seed() to scan packed reads (option -a)   */
+/*                                                                           */
+
+
+#include <stdio.h>
+#include <string.h>
+#include "defaults.h"
+#include "grepwalk.h"
+#include "examine_reads.h"
+
+#define MAX_KMER 32
+
+int fetch_stored_read(struct read_store *, long int, char *, char *);
+
+/* two bits of each base plus one; 0 for the others */
+static const unsigned char base_codes[256] =
+  { ['A'] = 1, ['C'] = 2, ['G'] = 3, ['T'] = 4 };
+
+
+uint64_t encode_word(char *sequence, int length)
+{
+  uint64_t code = 0;
+  int i;
+
+  for (i = 0; i < length; i++)
+  {
+    code = (code << 2) |
+           (uint64_t)(base_codes[(unsigned char)sequence[i]] - 1);
+  }
+  return code;
+}
+
+
+/*                                                                           */
+/* build_seed_matcher()                                                      */
+/*                                                                           */
+/*   This function prepares the codes of the seed of a walker.               */
+/*   It should be called whenever the seed is changed.                       */
+/*                                                                           */
+void build_seed_matcher(struct walker *w)
+{
+  struct matcher *m = &w->matcher;
+  int i, q;
+
+  m->k = (int)strlen(w->seed);
+  q = m->k < MAX_KMER ? m->k : MAX_KMER;
+  m->mask = q < MAX_KMER ? ((uint64_t)1 << (2 * q)) - 1 : ~(uint64_t)0;
+  for (i = 0; i < m->k; i++)
+  {
+    switch (w->seed[m->k - 1 - i])
+    {
+      case 'T': m->seed_minus[i] = 'A'; break;
+      case 'C': m->seed_minus[i] = 'G'; break;
+      case 'A': m->seed_minus[i] = 'T'; break;
+      case 'G': m->seed_minus[i] = 'C'; break;
+      default:  m->seed_minus[i] = w->seed[m->k - 1 - i];
+    }
+  }
+  m->seed_minus[m->k] = '\0';
+
+  /* a seed consists of only T, C, A, or G */
+  m->n_words = (m->k + MAX_KMER - 1) / MAX_KMER;
+  for (i = 0; i < m->n_words - 1; i++)
+  {
+    m->plus[i] = encode_word(w->seed + MAX_KMER * i, MAX_KMER);
+    m->minus[i] = encode_word(m->seed_minus + MAX_KMER * i, MAX_KMER);
+  }
+  m->plus[i] = encode_word(w->seed + m->k - q, q);
+  m->minus[i] = encode_word(m->seed_minus + m->k - q, q);
+}
+
+
+int same_words(uint64_t *codes, int start, uint64_t *words, int n_words)
+{	/* the last word has been compared */
+  int i;
+
+  for (i = 0; i < n_words - 1; i++)
+  { if (codes[start + MAX_KMER * (i + 1) - 1] != words[i]) return 0; }
+  return 1;
+}
+
+
+/*                                                                           */
+/* find_seed()                                                               */
+/*                                                                           */
+/*   This function searches an upper-case read for the seed of a walker.     */
+/*   It returns 1 when the seed is on the plus strand, with the position of  */
+/*   its leftmost occurrence in offset, or 2 when it is on the minus strand, */
+/*   with the position of the leftmost occurrence in the complementary       */
+/*   sequence, that is, the rightmost reverse complement in the read.        */
+/*   It returns 0 when the seed is not found.                                */
+/*   Since the read and the walker are not changed, threads can call this.   */
+/*                                                                           */
+int find_seed(struct walker *w, char *sequence, int *offset)
+{
+  struct matcher *m = &w->matcher;
+  int i, j, b, start, minus = -1, last = m->n_words - 1;
+  uint64_t code = 0, codes[MAX_CHAR];	/* codes kept for a long seed */
+
+  for (i = j = 0; sequence[i] != '\0'; i++)
+  {	/* j: number of successive bases that can be encoded */
+    if ((b = base_codes[(unsigned char)sequence[i]]) == 0) { j = 0; continue; }
+    code = ((code << 2) | (uint64_t)(b - 1)) & m->mask;
+    if (last > 0) codes[i] = code;
+    if (++j < m->k) continue;
+
+    start = i + 1 - m->k;
+    if (code == m->plus[last] &&
+        (last == 0 || same_words(codes, start, m->plus, m->n_words)))
+    {
+      *offset = start;
+      return 1;
+    }
+    if (code == m->minus[last] &&
+        (last == 0 || same_words(codes, start, m->minus, m->n_words)))
+    { minus = start; }
+  }
+  if (minus < 0) return 0;
+  *offset = i - minus - m->k;
+  return 2;
+}
+
+
+/*                                                                           */
+/* find_stored_seed()                                                        */
+/*                                                                           */
+/*   This function is the same as find_seed(), but searches the id-th read   */
+/*   of the store without unpacking it.  The codes are taken four bases at   */
+/*   a time from the bytes of the store, and then compared with the seed.    */
+/*   A read marked with N, which resets the rolling code, is unpacked and    */
+/*   passed to find_seed().                                                  */
+/*                                                                           */
+int find_stored_seed(struct walker *w, struct read_store *s, long int id,
+                     int *offset)
+{
+  struct matcher *m = &w->matcher;
+  int i, start, length, minus = -1, last = m->n_words - 1;
+  uint64_t n = s->offsets[id], end = s->offsets[id + 1], x, code = 0;
+  uint64_t codes[MAX_CHAR + 3];	/* code of the bases ending at each one */
+  char sequence[MAX_CHAR], qscores[MAX_CHAR];
+
+  length = (int)(end - n);
+  for (x = n / 8; length > 0 && x <= (end - 1) / 8; x++)
+  {	/* the byte may be shared with the next or the previous read */
+    if (s->ns[x] == 0) continue;
+    fetch_stored_read(s, id, sequence, qscores);
+    return find_seed(w, sequence, offset);
+  }
+
+  for (i = 0; i < length && n % 4 != 0; i++, n++)
+  {
+    code = (code << 2) | ((s->bases[n / 4] >> (2 * (n % 4))) & 3);
+    codes[i] = code & m->mask;
+  }
+  for (; i < length; i += 4, n += 4)
+  {	/* the last byte may hold bases of the next read */
+    x = s->bases[n / 4];
+    code = (code << 2) | (x & 3);
+    codes[i] = code & m->mask;
+    code = (code << 2) | (x >> 2 & 3);
+    codes[i + 1] = code & m->mask;
+    code = (code << 2) | (x >> 4 & 3);
+    codes[i + 2] = code & m->mask;
+    code = (code << 2) | (x >> 6);
+    codes[i + 3] = code & m->mask;
+  }
+
+  for (i = m->k - 1; i < length; i++)
+  {
+    start = i + 1 - m->k;
+    if (codes[i] == m->plus[last] &&
+        (last == 0 || same_words(codes, start, m->plus, m->n_words)))
+    {
+      *offset = start;
+      return 1;
+    }
+    if (codes[i] == m->minus[last] &&
+        (last == 0 || same_words(codes, start, m->minus, m->n_words)))
+    { minus = start; }
+  }
+  if (minus < 0) return 0;
+  *offset = length - minus - m->k;
+  return 2;
+}
@@ -4,6 +4,9 @@
 /*                                                                           */
 /* DESCRIPTION                                                               */
 /*   This module is called from grepwalk.c when option -t is provided.       */
+/*   Entries are taken in batches, and each of the n_threads threads trims   */
+/*   its own part of a batch into its own text.  The texts are then          */
+/*   written in the order of the threads, that is, of the input.             */
 /*                                                                           */
 /* AUTHOR                                                                    */
 /*   Coded by Kohji OKAMURA, Ph.D.                                           */
@@ -13,6 +16,10 @@
 /*   May 11, 2015  Diverge trim_bases.c from merge_fastq.c                   */
 /*   May 17, 2015  Include defaults.h                                        */
 /*   Aug 05, 2017  Support option -p to slim FASTQ                           */
+/*   Oct 17, 2026  Read entries with record_reader.c and trim them in place  */
+/*   Oct 17, 2026  Write the output through bgzf.c (option -z)               */
+/*   Oct 17, 2026  Trim batches of entries in threads (option -j)            */
+/*   Oct 17, 2026  Scan the quality scores with base_kernels.c               */
 /*                                                                           */
 
 
@@ -20,13 +27,44 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <zlib.h>
 #include "defaults.h"
+#include "record_reader.h"
+#include "bgzf.h"
 
 #define CODE_TO_SCORE (short int)(-33)
+#define SIZE_BATCH 0x1000
 
 
 extern int minimum_qscore;
 extern short int reduce_fastq;
+extern short int compress_output;
+extern int n_threads;
+
+struct record_reader *open_records(char *, int);
+int next_records(struct record_reader *, struct record *, int);
+void close_records(struct record_reader *);
+struct bgzf_output *open_output(FILE *, short int, int);
+void write_output(struct bgzf_output *, char *, size_t);
+void close_output(struct bgzf_output *);
+void append_text(struct text *, char *, size_t);
+int count_low_head(char *, int, int);
+int count_low_tail(char *, int, int);
+
+
+/**** entries trimmed by one thread ****/
+struct part
+{
+  struct record *records;
+  int first;
+  int last;
+  int broken;		/* position of a fasta entry, or -1 */
+  struct text text;
+};
+
+
+struct part trim_parts[MAX_THREADS];
 
 
 /*                                                                           */
@@ -34,44 +72,122 @@ extern short int reduce_fastq;
 /*                                                                           */
 /*   This function is called from trim_low_quality_bases().                  */
 /*   It returns an integer value that indicates the length should be         */
-/*   trimmed from the 3' end.                                                */
+/*   trimmed from the 3' end of quality scores of the given length.          */
+/*   The first score is not examined.                                        */
+/*                                                                           */
+int examine_3end(char *qscores, int length_qscores)
+{
+  return count_low_tail(qscores + 1, length_qscores - 1,
+                        minimum_qscore - (int)CODE_TO_SCORE);
+}
+
+
+/*                                                                           */
+/* examine_5end()                                                            */
+/*                                                                           */
+/*   This function is called from trim_low_quality_bases().                  */
+/*   It returns an integer value that indicates the length should be         */
+/*   trimmed from the 5' end of quality scores of the given length.          */
 /*                                                                           */
-int examine_3end(char *sequence)
+int examine_5end(char *qscores, int length_qscores)
+{
+  return count_low_head(qscores, length_qscores,
+                        minimum_qscore - (int)CODE_TO_SCORE);
+}
+
+
+/*                                                                           */
+/* print_trimmed_record()                                                    */
+/*                                                                           */
+/*   This function trims one entry and appends it to a text.                 */
+/*   Quality scores are cut to the length of the sequence.                   */
+/*                                                                           */
+void print_trimmed_record(struct text *t, struct record *r)
+{
+  int start, end, length_header, i;
+
+  /* trim low quality data at the 3' end */
+  end = r->length_qscores < r->length_sequence ?
+        r->length_qscores : r->length_sequence;
+  end -= examine_3end(r->qscores, end);
+
+  /* trin low quality data at the 5' end */
+  start = examine_5end(r->qscores, end);
+
+  /* print the four lines (one entry); short reads are to be eliminated */
+  length_header = r->length_header;
+  if (reduce_fastq == 1)	/* slim FASTQ */
+  {
+    for (i = 2; i < length_header; i++)	/* ignore the 1st and 2nd char */
+    {
+      if (isspace(r->header[i])) { length_header = i; break; }
+    }
+  }
+  append_text(t, r->header, length_header);
+  append_text(t, "\n", 1);
+  if (end - start < MIN_LENGTH) { append_text(t, "NNNNNNNN", 8); }
+  else { append_text(t, r->sequence + start, end - start); }
+  append_text(t, "\n", 1);
+  if (reduce_fastq == 1)
+  { append_text(t, r->length_third > 0 ? r->third : "\n", 1); }
+  else { append_text(t, r->third, r->length_third); }
+  append_text(t, "\n", 1);
+  if (end - start < MIN_LENGTH) { append_text(t, "########", 8); }
+  else { append_text(t, r->qscores + start, end - start); }
+  append_text(t, "\n", 1);
+}
+
+
+void *trim_part(void *arg)
 {
-  int length = 0;	/* trimmed length; this counter will be returned */
-  int score;
+  struct part *s = (struct part *)arg;
   int i;
 
-  for (i = strlen(sequence) - 1; i > 0; i--)
+  s->text.size = 0;
+  s->broken = -1;
+  for (i = s->first; i < s->last; i++)
   {
-    score = (int)sequence[i] + (int)CODE_TO_SCORE;
-    if (score < minimum_qscore) { length++; }
-    else { return length; }
+    if (s->records[i].qscores == NULL)	/* a fasta entry has no 4th line */
+    { s->broken = i; break; }
+    print_trimmed_record(&s->text, s->records + i);
   }
-  return length;
+  return NULL;
 }
 
 
 /*                                                                           */
-/* examine_5end()                                                            */
+/* trim_batch()                                                              */
 /*                                                                           */
-/*   This function is called from trim_low_quality_bases().                  */
-/*   It returns an integer value that indicates the length should be         */
-/*   trimmed from the 5' end.                                                */
+/*   This function divides n entries into n_threads parts, trims them at     */
+/*   the same time, and writes the texts in order.  It returns 1 when a      */
+/*   fasta entry is found, after the entries before it are written.          */
 /*                                                                           */
-int examine_5end(char *sequence)
+int trim_batch(struct bgzf_output *o, struct record *records, int n)
 {
-  int length = 0;	/* trimmed length; this counter will be returned */
-  int score;
-  unsigned int i = 0;
+  pthread_t threads[MAX_THREADS];
+  int size = (n + n_threads - 1) / n_threads;
+  int t;
+
+  for (t = 0; t < n_threads; t++)
+  {
+    trim_parts[t].records = records;
+    trim_parts[t].first = t * size < n ? t * size : n;
+    trim_parts[t].last = (t + 1) * size < n ? (t + 1) * size : n;
+  }
+  for (t = 1; t < n_threads; t++)
+  {
+    if (pthread_create(&threads[t], NULL, trim_part, &trim_parts[t]))
+    { ERROR_MESSAGE(227, "thread creation"); }
+  }
+  trim_part(&trim_parts[0]);
+  for (t = 1; t < n_threads; t++) pthread_join(threads[t], NULL);
 
-  for (; i < strlen(sequence); i++)
+  for (t = 0; t < n_threads; t++)
   {
-    score = (int)sequence[i] + (int)CODE_TO_SCORE;
-    if (score < minimum_qscore) { length++; }
-    else { return length; }
+    write_output(o, trim_parts[t].text.data, trim_parts[t].text.size);
+    if (trim_parts[t].broken >= 0) return 1;
   }
-  return length;
+  return 0;
 }
 
 
@@ -82,62 +198,38 @@ int examine_5end(char *sequence)
 /*   5' and 3' ends.                                                         */
 /*   The minimal score whose base is retained is defined as                  */
 /*   DEFAULT_MIN_QSCORE and can be changed with option -q.                   */
-/*   Trimmed FASTQ is printed onto the standard output.                      */
+/*   Trimmed FASTQ is printed onto the standard output, compressed into      */
+/*   BGZF with option -z.                                                    */
 /*   EXIT_SUCCESS is returned unless something wrong occurs.                 */
 /*                                                                           */
 int trim_low_quality_bases(char *name_fastq)
 {
-  char *line1_start, *line3_start;
-  char line[4][MAX_CHAR];
-  int length, len, i;
-  FILE *fastq;
+  static struct record records[SIZE_BATCH];
+  struct record_reader *fastq;
+  struct bgzf_output *output;
+  int t, n;
 
   /**** open the FASTQ file ****/
-  if ((fastq = fopen(name_fastq, "r")) == NULL)
+  if ((fastq = open_records(name_fastq, n_threads)) == NULL)
   { ERROR_MESSAGE(212, name_fastq); }
+  output = open_output(stdout, compress_output, n_threads);
 
-  while (fgets(line[0], MAX_CHAR, fastq) != NULL)
+  while ((n = next_records(fastq, records, SIZE_BATCH)) > 0)
   {
-    if ((fgets(line[1], MAX_CHAR, fastq)) == NULL)
-    { ERROR_MESSAGE(213, line[1]); }
-    if ((fgets(line[2], MAX_CHAR, fastq)) == NULL)
-    { ERROR_MESSAGE(214, line[1]); }
-    if ((fgets(line[3], MAX_CHAR, fastq)) == NULL)
-    { ERROR_MESSAGE(215, line[1]); }
-
-    /* trim low quality data at the 3' end */
-    line[3][strlen(line[1])] = '\0';	/* replace \n with \0 */
-    length = strlen(line[3]);
-    len = examine_3end(line[3]);
-    line[1][length - len] = line[3][length - len] = '\0';
-
-    /* trin low quality data at the 5' end */
-    len = examine_5end(line[3]);
-    line1_start = line[1] + len;
-    line3_start = line[3] + len;
-
-    /* short reads are to be eliminated */
-    if (strlen(line1_start) < MIN_LENGTH)
+    if (trim_batch(output, records, n))
     {
-      strcpy(line1_start, "NNNNNNNN");
-      strcpy(line3_start, "########");
+      close_output(output);
+      ERROR_MESSAGE(215, name_fastq);
     }
-
-    /* print the four lines (one entry) */
-    if (reduce_fastq == 1)	/* slim FASTQ */
-    {
-      len = (int)strlen(line[0]);
-      for (i = 2; i < (len - 1); i++)	/* ignore the 1st and 2nd char */
-      {
-        if (isspace(line[0][i]))
-        { line[0][i] = '\n'; line[0][i + 1] = '\0'; break; }
-      }
-      line[2][1] = '\n'; line[2][2] = '\0';
-    }
-    fprintf(stdout, "%s%s\n%s%s\n",
-      line[0], line1_start, line[2], line3_start);
+  }
+  if (fastq->error > 0)	/* lines read of the last entry */
+  {
+    close_output(output);
+    ERROR_MESSAGE(212 + fastq->error, name_fastq);
   }
 
-  fclose(fastq);
+  close_output(output);
+  close_records(fastq);
+  for (t = 0; t < n_threads; t++) free(trim_parts[t].text.data);
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,133 @@
+/*                                                                           */
+/* NAME                                                                      */
+/*   walk_stats.c - write a row for each extension of a walk (option -T)     */
+/*                                                                           */
+/* DESCRIPTION                                                               */
+/*   This module is called from libgrepwalk.c, read_reads.c, and             */
+/*   examine_reads.c when option -T is provided.                             */
+/*   A tab-separated row is written into the file each time a seed is        */
+/*   extended, by check_read() or by lastly_struggle(), with the pass, the   */
+/*   reads and bytes scanned so far, the seed hits on each strand and the    */
+/*   reads rejected by the quality window since the last extension of the    */
+/*   walker, the entries in its nominee table, the depths of the chosen      */
+/*   extension, and the elapsed time.  At the end, a table of the seconds    */
+/*   spent in each phase, the numbers of passes and dropped reads, and the   */
+/*   peak memory is appended.  Like the tables of option -Q, each table      */
+/*   begins with a line of column names beginning with '#'.                  */
+/*                                                                           */
+/* AUTHOR                                                                    */
+/*   Coded by Kohji OKAMURA, Ph.D.                                           */
+/*                                                                           */
+/* HISTORY                                                                   */
+/*   Oct 17, 2026  Started to code                                           */
+/*   Oct 17, 2026  Keep the counters in struct walk_stats for libgrepwalk    */
+/*   Oct 17, 2026  Add the number of reads dropped with option -D            */
+/*                                                                           */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include "defaults.h"
+#include "grepwalk.h"
+#include "examine_reads.h"
+
+
+double seconds_since(struct timeval *t)
+{
+  struct timeval now;
+
+  gettimeofday(&now, NULL);
+  return (double)(now.tv_sec - t->tv_sec) +
+         (double)(now.tv_usec - t->tv_usec) / 1e6;
+}
+
+
+/*                                                                           */
+/* open_walk_stats()                                                         */
+/*                                                                           */
+/*   This function is called from write_walk_stats() before reads are        */
+/*   trimmed and merged (option -P), indexed, or loaded, which are timed as  */
+/*   the first phase.  The line of column names is written here.             */
+/*                                                                           */
+void open_walk_stats(struct walk_stats *t, char *name)
+{
+  if ((t->fp = fopen(name, "w")) == NULL)
+  { ERROR_MESSAGE(231, name); }
+  gettimeofday(&t->time_start, NULL);
+  t->time_phase = t->time_start;
+  fprintf(t->fp, "#step\twalker\tpass\treads\tbytes\thits_plus\t"
+          "hits_minus\trejected\tnominees\tdepth_plus\tdepth_minus\t"
+          "extended\tlength\tseconds\n");
+}
+
+
+/*                                                                           */
+/* switch_phase()                                                            */
+/*                                                                           */
+/*   This function adds the time of the current phase to its total and       */
+/*   begins the next one.                                                    */
+/*                                                                           */
+void switch_phase(struct walk_stats *t, int next)
+{
+  if (t->fp == NULL) return;
+  t->seconds_phases[t->phase] += seconds_since(&t->time_phase);
+  gettimeofday(&t->time_phase, NULL);
+  t->phase = next;
+}
+
+
+/*                                                                           */
+/* print_step()                                                              */
+/*                                                                           */
+/*   This function writes a row for an extension of a walker by length       */
+/*   bases with the depths of the chosen nominee, and resets the counters    */
+/*   of the walker.  It is called after the assembled length is updated and  */
+/*   before the nominee table is emptied.                                    */
+/*                                                                           */
+void print_step(struct walker *w, int length, int depth_plus, int depth_minus)
+{
+  struct walk_stats *t = &w->gw->stats;
+
+  if (t->fp != NULL)
+  {
+    fprintf(t->fp, "%ld\t%d\t%d\t%ld\t%ld\t%ld\t%ld\t%ld\t%d\t%d\t%d\t"
+            "%d\t%ld\t%.6f\n", ++t->n_steps, (int)(w - w->gw->walkers),
+            t->n_passes, t->n_scanned, t->bytes_scanned, w->hits_plus,
+            w->hits_minus, w->rejected, w->n_table, depth_plus, depth_minus,
+            length, w->length_assembled, seconds_since(&t->time_start));
+  }
+  w->hits_plus = w->hits_minus = w->rejected = 0;
+}
+
+
+/*                                                                           */
+/* close_walk_stats()                                                        */
+/*                                                                           */
+/*   This function appends the summary and closes the file.                  */
+/*                                                                           */
+void close_walk_stats(struct walk_stats *t)
+{
+  static const char *names[N_PHASES] =
+  { "prepare", "scan", "struggle", "output" };
+  struct rusage usage;
+  int i;
+
+  if (t->fp == NULL) return;
+  switch_phase(t, t->phase);
+  getrusage(RUSAGE_SELF, &usage);
+  fprintf(t->fp, "#summary\tvalue\n");
+  for (i = 0; i < N_PHASES; i++)
+  { fprintf(t->fp, "seconds_%s\t%.6f\n", names[i], t->seconds_phases[i]); }
+  fprintf(t->fp, "seconds_total\t%.6f\n", seconds_since(&t->time_start));
+  fprintf(t->fp, "passes\t%d\n", t->n_passes);
+  fprintf(t->fp, "reads\t%ld\n", t->n_scanned);
+  fprintf(t->fp, "bytes\t%ld\n", t->bytes_scanned);
+  fprintf(t->fp, "steps\t%ld\n", t->n_steps);
+  fprintf(t->fp, "dropped\t%ld\n", t->n_dropped);
+  fprintf(t->fp, "peak_rss_kB\t%ld\n", (long int)usage.ru_maxrss);
+  fclose(t->fp);
+  t->fp = NULL;
+}